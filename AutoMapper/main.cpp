@@ -1,6 +1,7 @@
 #include <fstream>
 #include <array>
 #include "../OsuParser.hpp"
+#include "../BeatmapAnalyze/include/Snap.hpp"
 
 constexpr inline auto columns = 4;
 
@@ -115,12 +116,17 @@ auto ParseBeat(std::vector<int>const& timePoints, std::array<std::vector<bool>,
 	return GenerateHitObject(timePoints, beats[track], track);
 }
 
-auto ProcessHitSound(std::vector<std::unique_ptr<HitObject>>& hitObjects, float const beatLength, int const offset)
+/**
+ * @brief Put a clap on every object that is on a whole beat
+ * @param tolerance Maximum distance in milliseconds from the beat
+ */
+auto ProcessHitSound(OsuFile& osuFile, double tolerance)
 {
-	for (auto& hitObject : hitObjects)
+	auto const report = Analyze::ClassifySnaps(osuFile, Analyze::SnapOptions{ tolerance });
+	for (size_t i = 0; i < osuFile.hitObjects.size(); ++i)
 	{
-		if (auto const multiple = (hitObject->time - offset) / beatLength; std::abs(multiple - std::roundf(multiple)) <= 0.1)
-			hitObject->hitSound = HitObject::HitSound::Clap;
+		if (report.snaps[i] == Analyze::SnapDivisor::Whole)
+			osuFile.hitObjects[i]->hitSound = HitObject::HitSound::Clap;
 	}
 }
 
@@ -161,7 +167,7 @@ int main()
 	osuFile.difficulty.HPDrainRate = 3;
 	osuFile.difficulty.overallDifficulty = 5;
 	osuFile.hitObjects = ParseBeat(timePoints, beats);
-	//ProcessHitSound(osuFile.hitObjects, t.beatLength, t.time);
+	//ProcessHitSound(osuFile, t.beatLength * 0.1);
 	osuFile.save();
 
 	for (int i = 0; i < columns; ++i)
@@ -0,0 +1,100 @@
+#include "include/Density.hpp"
+#include "include/TimingSweep.hpp"
+
+Analyze::ActiveSpans Analyze::GetActiveSpans(OsuFile const& beatmap)
+{
+    ActiveSpans spans;
+    spans.startTimes.reserve(beatmap.hitObjects.size());
+    spans.endTimes.reserve(beatmap.hitObjects.size());
+
+    TimingSweep sweep{ beatmap.timingPoints };
+    for (auto const& object : beatmap.hitObjects)
+    {
+        auto endTime = object->time;
+        switch (object->type)
+        {
+            case HitObject::Type::Hold:
+                endTime = static_cast<Hold const&>(*object).endTime;
+                break;
+            case HitObject::Type::Spinner:
+                endTime = static_cast<Spinner const&>(*object).endTime;
+                break;
+            case HitObject::Type::Slider:
+                endTime = static_cast<int>(sweep.advanceTo(object->time).getSliderEndTime(static_cast<Slider const&>(*object), beatmap.difficulty.sliderMultiplier));
+                break;
+            default:
+                break;
+        }
+        spans.startTimes.push_back(object->time);
+        spans.endTimes.push_back(std::max(endTime, object->time));
+    }
+
+    /*Objects are usually sorted already, and end times are nearly sorted, so these are cheap*/
+    if (!std::is_sorted(spans.startTimes.cbegin(), spans.startTimes.cend()))
+        std::sort(spans.startTimes.begin(), spans.startTimes.end());
+    if (!std::is_sorted(spans.endTimes.cbegin(), spans.endTimes.cend()))
+        std::sort(spans.endTimes.begin(), spans.endTimes.end());
+    return spans;
+}
+
+std::vector<float> Analyze::ComputeNpsCurve(
+    std::vector<int> const& sortedStartTimes,
+    std::vector<int> const& sortedEndTimes,
+    int firstTime,
+    int lastTime,
+    int windowSize,
+    int step)
+{
+    assert(sortedStartTimes.size() == sortedEndTimes.size());
+    if (windowSize <= 0 || step <= 0 || lastTime < firstTime)
+        return {};
+
+    std::vector<float> curve;
+    curve.reserve((lastTime - firstTime) / step + 1);
+
+    /*
+        active(t) = #(start < t + windowSize) - #(end < t)
+        Both counts only grow as t increases, so each is a pointer moving forward.
+    */
+    auto const count = sortedStartTimes.size();
+    size_t started = 0, ended = 0;
+    auto const perSecond = 1'000.f / windowSize;
+    for (auto windowStart = firstTime; windowStart <= lastTime; windowStart += step)
+    {
+        while (started < count && sortedStartTimes[started] < windowStart + windowSize)
+            ++started;
+        while (ended < count && sortedEndTimes[ended] < windowStart)
+            ++ended;
+        curve.push_back(static_cast<float>(started - ended) * perSecond);
+    }
+    return curve;
+}
+
+float Analyze::DensityAnalysis::getPercentile(float percent) const
+{
+    if (curve.empty())
+        return 0;
+
+    auto copy = curve;
+    auto const index = static_cast<size_t>(std::clamp(percent, 0.f, 100.f) / 100.f * (copy.size() - 1) + 0.5f);
+    std::nth_element(copy.begin(), copy.begin() + index, copy.end());
+    return copy[index];
+}
+
+Analyze::DensityAnalysis Analyze::AnalyzeDensity(OsuFile const& beatmap, DensityOptions const& options)
+{
+    DensityAnalysis result;
+    result.options = options;
+    if (beatmap.hitObjects.empty())
+        return result;
+
+    auto const spans = GetActiveSpans(beatmap);
+    result.startTime = spans.startTimes.front();
+    result.curve = ComputeNpsCurve(spans.startTimes, spans.endTimes, result.startTime, spans.endTimes.back(), options.windowSize, options.step);
+    if (!result.curve.empty())
+        result.peak = *std::max_element(result.curve.cbegin(), result.curve.cend());
+
+    if (auto const drainTime = spans.endTimes.back() - spans.startTimes.front() - beatmap.getTotalBreakTime(); drainTime > 0)
+        result.drainNormalized = spans.size() * 1'000.f / drainTime;
+    return result;
+}
@@ -0,0 +1,263 @@
+#include "include/JumpAnalyzer.hpp"
+#include "include/TimingSweep.hpp"
+#include <atomic>
+#include <future>
+#include <thread>
+
+std::ostream& Analyze::operator<<(std::ostream& os, PairType type)
+{
+    switch (type)
+    {
+        case PairType::None:
+            os << "None";
+            break;
+        case PairType::Stack:
+            os << "Stack";
+            break;
+        case PairType::Burst:
+            os << "Burst";
+            break;
+        case PairType::Stream:
+            os << "Stream";
+            break;
+        case PairType::Jump:
+            os << "Jump";
+            break;
+        default:
+            break;
+    }
+    return os;
+}
+
+/**
+ * @brief Mark runs of 1/4 pairs as bursts or streams
+ * @param isQuarter Whether each pair is a 1/4 pair that is not a jump nor a stack
+ */
+static void ClassifyRuns(std::vector<bool> const& isQuarter, std::vector<Analyze::PairType>& type, int minStreamObjects)
+{
+    auto const count = isQuarter.size();
+    for (size_t i = 0; i < count;)
+    {
+        if (!isQuarter[i])
+        {
+            ++i;
+            continue;
+        }
+
+        auto runEnd = i;
+        while (runEnd < count && isQuarter[runEnd])
+            ++runEnd;
+
+        /*A run of n pairs covers n + 1 objects, a single 1/4 pair is just a double*/
+        auto const objects = static_cast<int>(runEnd - i) + 1;
+        if (objects >= 3)
+            std::fill(type.begin() + i, type.begin() + runEnd, objects >= minStreamObjects ? Analyze::PairType::Stream : Analyze::PairType::Burst);
+        i = runEnd;
+    }
+}
+
+Analyze::JumpAnalysis Analyze::AnalyzeJumps(
+    std::vector<std::unique_ptr<HitObject>> const& hitObjects,
+    std::vector<TimingPoint> const& timingPoints,
+    JumpAnalyzerOptions const& options)
+{
+    JumpAnalysis result;
+    result.summary.objectCount = static_cast<int>(hitObjects.size());
+    if (hitObjects.size() < 2)
+        return result;
+
+    /*Gather the objects into flat arrays first, so that the per-pair math below runs over contiguous memory*/
+    auto const objectCount = hitObjects.size();
+    std::vector<float> x(objectCount), y(objectCount), time(objectCount), beatLength(objectCount);
+    std::vector<bool> isSpinner(objectCount);
+
+    TimingSweep sweep{ timingPoints };
+    auto const sectionLength = options.sectionLengthInBeats * sweep.getBeatLength();
+    for (size_t i = 0; i < objectCount; ++i)
+    {
+        auto const& object = *hitObjects[i];
+        sweep.advanceTo(object.time);
+        x[i] = static_cast<float>(object.x);
+        y[i] = static_cast<float>(object.y);
+        time[i] = static_cast<float>(object.time);
+        beatLength[i] = static_cast<float>(sweep.getBeatLength());
+        isSpinner[i] = object.type == HitObject::Type::Spinner;
+    }
+
+    auto const pairCount = objectCount - 1;
+    auto& pairs = result.pairs;
+    pairs.distance.resize(pairCount);
+    pairs.timeDelta.resize(pairCount);
+    pairs.angle.resize(pairCount);
+    pairs.velocity.resize(pairCount);
+    pairs.bpm.resize(pairCount);
+    pairs.type.assign(pairCount, PairType::None);
+
+    std::vector<float> dx(pairCount), dy(pairCount);
+    for (size_t i = 0; i < pairCount; ++i)
+    {
+        dx[i] = x[i + 1] - x[i];
+        dy[i] = y[i + 1] - y[i];
+        pairs.timeDelta[i] = time[i + 1] - time[i];
+    }
+    for (size_t i = 0; i < pairCount; ++i)
+    {
+        pairs.distance[i] = std::sqrt(dx[i] * dx[i] + dy[i] * dy[i]);
+        pairs.velocity[i] = pairs.timeDelta[i] > 0 ? pairs.distance[i] / pairs.timeDelta[i] : 0.f;
+        pairs.bpm[i] = 60'000.f / beatLength[i];
+    }
+    for (size_t i = 0; i < pairCount; ++i)
+        pairs.angle[i] = static_cast<float>(std::atan2(dy[i], dx[i]) * 180.0 / 3.14159265358979);
+
+    /*Classify*/
+    std::vector<bool> isQuarter(pairCount);
+    for (size_t i = 0; i < pairCount; ++i)
+    {
+        if (isSpinner[i] || isSpinner[i + 1] || pairs.timeDelta[i] <= 0)
+            continue;
+
+        auto const quarter = beatLength[i] / 4 + options.snapTolerance;
+        auto const half = beatLength[i] / 2 + options.snapTolerance;
+        auto const distance = pairs.distance[i];
+        auto const timeDelta = pairs.timeDelta[i];
+
+        if (distance < options.stackDistance)
+        {
+            if (timeDelta <= beatLength[i])
+                pairs.type[i] = PairType::Stack;
+        }
+        else if (distance >= options.jumpDistance)
+        {
+            if (timeDelta <= half)
+                pairs.type[i] = PairType::Jump;
+        }
+        else if (timeDelta <= quarter)
+            isQuarter[i] = true;
+    }
+    ClassifyRuns(isQuarter, pairs.type, options.minStreamObjects);
+
+    /*Summary and sections*/
+    auto& summary = result.summary;
+    double jumpDistanceSum{};
+    auto const firstTime = time.front();
+    for (size_t i = 0; i < pairCount; ++i)
+    {
+        auto const type = pairs.type[i];
+        ++summary.pairCounts[static_cast<size_t>(type)];
+        if (type == PairType::Jump)
+        {
+            jumpDistanceSum += pairs.distance[i];
+            summary.maxJumpVelocity = std::max(summary.maxJumpVelocity, pairs.velocity[i]);
+            summary.maxJumpBPM = std::max(summary.maxJumpBPM, pairs.bpm[i]);
+        }
+
+        auto const sectionIndex = static_cast<size_t>((time[i] - firstTime) / sectionLength);
+        while (result.sections.size() <= sectionIndex)
+        {
+            SectionHistogram section;
+            section.startTime = static_cast<int>(firstTime + result.sections.size() * sectionLength);
+            result.sections.push_back(section);
+        }
+        auto& section = result.sections[sectionIndex];
+        ++section.types[static_cast<size_t>(type)];
+        if (type != PairType::None)
+            ++section.distances[std::min(static_cast<int>(pairs.distance[i]) / SectionHistogram::DistanceBinWidth, SectionHistogram::DistanceBins - 1)];
+    }
+    if (auto const jumps = summary.pairCounts[static_cast<size_t>(PairType::Jump)]; jumps != 0)
+        summary.averageJumpDistance = static_cast<float>(jumpDistanceSum / jumps);
+
+    return result;
+}
+
+Analyze::JumpAnalysis Analyze::AnalyzeJumps(OsuFile const& beatmap, JumpAnalyzerOptions const& options)
+{
+    return AnalyzeJumps(beatmap.hitObjects, beatmap.timingPoints, options);
+}
+
+float Analyze::JumpAnalysis::getPercentOf(PairType type, float minBPM) const
+{
+    if (pairs.size() == 0)
+        return 0;
+
+    int count{};
+    for (size_t i = 0; i < pairs.size(); ++i)
+        count += pairs.type[i] == type && pairs.bpm[i] >= minBPM;
+    return count / static_cast<float>(pairs.size());
+}
+
+std::ostream& Analyze::operator<<(std::ostream& os, JumpSummary const& summary)
+{
+    os << summary.objectCount << " objects";
+    for (size_t i = 1; i < summary.pairCounts.size(); ++i)
+        os << ", " << static_cast<PairType>(i) << ": " << summary.pairCounts[i];
+    os << ", average jump distance: " << summary.averageJumpDistance
+        << ", max jump velocity: " << summary.maxJumpVelocity
+        << ", max jump BPM: " << summary.maxJumpBPM;
+    return os;
+}
+
+/**
+ * @brief Parse only what the jump analyzer needs, returns nothing if it's not an osu!standard map
+ */
+static std::optional<Analyze::LibraryEntry> AnalyzeLibraryEntry(std::filesystem::path const& path, float minBPM, Analyze::JumpAnalyzerOptions const& options)
+{
+    std::ifstream file{ path };
+    General const general{ file };
+    if (general.mode != Mode::Osu)
+        return {};
+
+    /*[TimingPoints] is always before [HitObjects], so both are read in one go*/
+    auto const timingPoints = TimingPoint::HandleTimingPoints(file);
+    auto const hitObjects = HitObject::HandleHitObjects(file);
+
+    auto const analysis = Analyze::AnalyzeJumps(hitObjects, timingPoints, options);
+    return Analyze::LibraryEntry{ path, analysis.summary, analysis.getPercentOf(Analyze::PairType::Jump, minBPM) };
+}
+
+std::vector<Analyze::LibraryEntry> Analyze::AnalyzeLibrary(
+    std::filesystem::path const& root,
+    float minBPM,
+    std::function<bool(LibraryEntry const&)> const& filter,
+    JumpAnalyzerOptions const& options)
+{
+    std::vector<std::filesystem::path> paths;
+    for (auto const& entry : std::filesystem::recursive_directory_iterator{ root })
+    {
+        if (entry.is_regular_file() && entry.path().extension() == ".osu")
+            paths.push_back(entry.path());
+    }
+
+    /*A fixed number of workers pulling from a shared index, rather than one thread per file*/
+    std::vector<std::optional<LibraryEntry>> entries(paths.size());
+    std::atomic<size_t> nextIndex{};
+    auto worker = [&]()
+    {
+        for (auto i = nextIndex++; i < paths.size(); i = nextIndex++)
+        {
+            try
+            {
+                if (auto entry = AnalyzeLibraryEntry(paths[i], minBPM, options); entry && (!filter || filter(*entry)))
+                    entries[i] = std::move(entry);
+            }
+            catch (std::exception const& e)
+            {
+                Log(LogLevel::Warning, "Cannot analyze ", paths[i].string(), ": ", e.what());
+            }
+        }
+    };
+
+    std::vector<std::future<void>> workers;
+    auto const threadCount = std::max(1u, std::thread::hardware_concurrency());
+    for (unsigned i = 0; i < threadCount; ++i)
+        workers.emplace_back(std::async(std::launch::async, worker));
+    for (auto& future : workers)
+        future.get();
+
+    std::vector<LibraryEntry> result;
+    for (auto& entry : entries)
+    {
+        if (entry)
+            result.emplace_back(std::move(*entry));
+    }
+    return result;
+}
@@ -0,0 +1,105 @@
+#include "include/Lint.hpp"
+#include "include/TimingSweep.hpp"
+#include <numeric>
+#include <limits>
+
+std::ostream& Analyze::operator<<(std::ostream& os, LintCheck check)
+{
+    switch (check)
+    {
+        case LintCheck::Unsorted:       os << "Unsorted"; break;
+        case LintCheck::Overlap:        os << "Overlap"; break;
+        case LintCheck::ReversedHold:   os << "ReversedHold"; break;
+        case LintCheck::InBreak:        os << "InBreak"; break;
+        case LintCheck::ShortHold:      os << "ShortHold"; break;
+        default:                        os << "Unknown"; break;
+    }
+    return os;
+}
+
+std::ostream& Analyze::operator<<(std::ostream& os, LintIssue const& issue)
+{
+    os << issue.time << "ms";
+    if (issue.column != -1)
+        os << " column " << issue.column;
+    os << ": " << issue.check;
+    return os;
+}
+
+std::ostream& Analyze::operator<<(std::ostream& os, LintReport const& report)
+{
+    for (size_t i = 0; i < report.counts.size(); ++i)
+        os << static_cast<LintCheck>(i) << ": " << report.counts[i] << (i + 1 == report.counts.size() ? '\n' : '\t');
+    for (auto const& issue : report.issues)
+        os << '\t' << issue << '\n';
+    return os;
+}
+
+Analyze::LintReport Analyze::Lint(OsuFile const& beatmap, LintOptions const& options)
+{
+    LintReport report;
+    auto const& hitObjects = beatmap.hitObjects;
+    auto const addIssue = [&report](LintCheck check, size_t index, int time, int column)
+    {
+        report.issues.push_back(LintIssue{ check, index, time, column });
+        ++report.counts[static_cast<size_t>(check)];
+    };
+
+    /*Unsorted objects are reported in file order, then the sweep runs on the time order*/
+    std::vector<size_t> order(hitObjects.size());
+    std::iota(order.begin(), order.end(), 0);
+    bool sorted = true;
+    for (size_t i = 1; i < hitObjects.size(); ++i)
+    {
+        if (hitObjects[i]->time < hitObjects[i - 1]->time)
+        {
+            addIssue(LintCheck::Unsorted, i, hitObjects[i]->time, -1);
+            sorted = false;
+        }
+    }
+    if (!sorted)
+        std::stable_sort(order.begin(), order.end(), [&hitObjects](size_t lhs, size_t rhs) { return hitObjects[lhs]->time < hitObjects[rhs]->time; });
+
+    auto breaks = beatmap.events.breaks;
+    std::sort(breaks.begin(), breaks.end(), [](Break const& lhs, Break const& rhs) { return lhs.startTime < rhs.startTime; });
+    size_t nextBreak = 0;
+
+    auto const isMania = beatmap.general.mode == Mode::Mania;
+    auto const keyCount = std::max(1, static_cast<int>(std::lround(beatmap.difficulty.circleSize)));
+    std::vector<int> columnEndTimes(isMania ? keyCount : 0, std::numeric_limits<int>::min());
+
+    TimingSweep sweep{ beatmap.timingPoints };
+    for (auto const index : order)
+    {
+        auto const& object = *hitObjects[index];
+        auto const time = object.time;
+        auto const isHold = object.type == HitObject::Type::Hold;
+        auto const endTime = isHold ? static_cast<Hold const&>(object).endTime : time;
+        auto const column = isMania ? object.getColumnIndex(keyCount) : -1;
+
+        if (isMania)
+        {
+            if (time <= columnEndTimes[column])
+                addIssue(LintCheck::Overlap, index, time, column);
+            columnEndTimes[column] = std::max(columnEndTimes[column], endTime);
+        }
+
+        if (isHold)
+        {
+            if (endTime < time)
+                addIssue(LintCheck::ReversedHold, index, time, column);
+            else if (endTime - time < sweep.advanceTo(time).getBeatLength() / options.minHoldDivisor)
+                addIssue(LintCheck::ShortHold, index, time, column);
+        }
+
+        /*Breaks that end before this object can't contain any later object either*/
+        while (nextBreak < breaks.size() && breaks[nextBreak].endTime <= time)
+            ++nextBreak;
+        if (nextBreak < breaks.size() && breaks[nextBreak].startTime < endTime && time < breaks[nextBreak].endTime)
+            addIssue(LintCheck::InBreak, index, time, column);
+    }
+
+    if (!sorted)
+        std::stable_sort(report.issues.begin(), report.issues.end(), [](LintIssue const& lhs, LintIssue const& rhs) { return lhs.time < rhs.time; });
+    return report;
+}
@@ -0,0 +1,276 @@
+#include "include/ManiaAnalyzer.hpp"
+#include "include/Density.hpp"
+#include <limits>
+
+std::vector<Analyze::ColumnNotes> Analyze::SplitColumns(OsuFile const& beatmap)
+{
+    return SplitColumns(beatmap.hitObjects, static_cast<int>(std::lround(beatmap.difficulty.circleSize)));
+}
+
+std::vector<Analyze::ColumnNotes> Analyze::SplitColumns(std::vector<std::unique_ptr<HitObject>> const& hitObjects, int keyCount)
+{
+    keyCount = std::max(1, keyCount);
+    std::vector<ColumnNotes> columns(keyCount);
+
+    for (auto const& object : hitObjects)
+    {
+        auto const endTime = object->type == HitObject::Type::Hold ? static_cast<Hold const&>(*object).endTime : object->time;
+        columns[object->getColumnIndex(keyCount)].add(object->time, std::max(endTime, object->time));
+    }
+
+    /*Converted maps are not necessarily in time order*/
+    for (auto& column : columns)
+    {
+        if (std::is_sorted(column.startTimes.cbegin(), column.startTimes.cend()))
+            continue;
+
+        std::vector<std::pair<int, int>> notes(column.size());
+        for (size_t i = 0; i < notes.size(); ++i)
+            notes[i] = { column.startTimes[i], column.endTimes[i] };
+        std::stable_sort(notes.begin(), notes.end(), [](auto const& lhs, auto const& rhs) { return lhs.first < rhs.first; });
+        for (size_t i = 0; i < notes.size(); ++i)
+            std::tie(column.startTimes[i], column.endTimes[i]) = notes[i];
+    }
+    return columns;
+}
+
+namespace
+{
+    /**
+     * @brief Follows the rows with a single note to find trills and rolls
+     */
+    class SingleNoteRuns
+    {
+        Analyze::ManiaAnalyzerOptions const& options;
+        Analyze::ManiaAnalysis& result;
+
+        int previousColumn = -1;
+        int previousTime{};
+        int trillLength = 0;
+        int trillOtherColumn = -1;
+        int rollLength = 0;
+        int rollDirection = 0;
+
+        void endTrill()
+        {
+            if (trillLength >= options.minPatternNotes)
+            {
+                ++result.trillCount;
+                result.trillNotes += trillLength;
+            }
+            trillLength = 0;
+        }
+
+        void endRoll()
+        {
+            if (rollLength >= options.minPatternNotes)
+            {
+                ++result.rollCount;
+                result.rollNotes += rollLength;
+            }
+            rollLength = 0;
+        }
+    public:
+        SingleNoteRuns(Analyze::ManiaAnalyzerOptions const& options, Analyze::ManiaAnalysis& result) : options{ options }, result{ result } {}
+
+        ~SingleNoteRuns()
+        {
+            endTrill();
+            endRoll();
+        }
+
+        void add(int column, int time)
+        {
+            auto const connected = previousColumn != -1 && column != previousColumn && time - previousTime <= options.maxPatternGap;
+            if (!connected)
+            {
+                endTrill();
+                endRoll();
+                trillLength = rollLength = 1;
+            }
+            else
+            {
+                /*A trill keeps going back to the column before the previous one*/
+                if (trillLength >= 2 && column == trillOtherColumn)
+                    ++trillLength;
+                else
+                {
+                    endTrill();
+                    trillLength = 2;
+                }
+                trillOtherColumn = previousColumn;
+
+                /*A roll keeps moving 1 column in the same direction*/
+                auto const direction = column - previousColumn;
+                if (std::abs(direction) != 1)
+                {
+                    endRoll();
+                    rollLength = 1;
+                }
+                else if (rollLength >= 2 && direction == rollDirection)
+                    ++rollLength;
+                else
+                {
+                    endRoll();
+                    rollLength = 2;
+                }
+                rollDirection = direction;
+            }
+            previousColumn = column;
+            previousTime = time;
+        }
+
+        /**
+         * @brief A chord breaks any trill or roll
+         */
+        void breakRuns()
+        {
+            endTrill();
+            endRoll();
+            previousColumn = -1;
+        }
+    };
+}
+
+Analyze::ManiaAnalysis Analyze::AnalyzeMania(std::vector<ColumnNotes> const& columns, ManiaAnalyzerOptions const& options)
+{
+    ManiaAnalysis result;
+    auto const keyCount = static_cast<int>(columns.size());
+    result.keyCount = keyCount;
+    result.columnCounts.resize(keyCount);
+    result.jackCounts.resize(keyCount);
+    result.minJackGaps.resize(keyCount, -1);
+    result.chordSizes.resize(keyCount + 1);
+
+    std::vector<std::pair<int, int>> holds;
+    for (int column = 0; column < keyCount; ++column)
+    {
+        auto const& notes = columns[column];
+        result.columnCounts[column] = static_cast<int>(notes.size());
+        result.noteCount += static_cast<int>(notes.size());
+
+        if (column < keyCount / 2)
+            result.leftHandNotes += static_cast<int>(notes.size());
+        else if (column >= (keyCount + 1) / 2)
+            result.rightHandNotes += static_cast<int>(notes.size());
+
+        auto minGap = std::numeric_limits<int>::max();
+        for (size_t i = 0; i < notes.size(); ++i)
+        {
+            if (notes.isHold(i))
+                holds.emplace_back(notes.startTimes[i], notes.endTimes[i]);
+            if (i == 0)
+                continue;
+
+            auto const gap = notes.startTimes[i] - notes.startTimes[i - 1];
+            minGap = std::min(minGap, gap);
+            if (gap <= options.maxJackGap)
+                ++result.jackCounts[column];
+        }
+        if (notes.size() >= 2)
+            result.minJackGaps[column] = minGap;
+    }
+    result.holdCount = static_cast<int>(holds.size());
+    if (result.noteCount == 0)
+        return result;
+
+    /*Merge the columns in time order to find the rows (chords), and trills and rolls between single notes*/
+    {
+        std::vector<size_t> heads(keyCount);
+        SingleNoteRuns runs{ options, result };
+        while (true)
+        {
+            auto time = std::numeric_limits<int>::max();
+            for (int column = 0; column < keyCount; ++column)
+            {
+                if (heads[column] < columns[column].size())
+                    time = std::min(time, columns[column].startTimes[heads[column]]);
+            }
+            if (time == std::numeric_limits<int>::max())
+                break;
+
+            int chordSize{}, chordColumn{};
+            for (int column = 0; column < keyCount; ++column)
+            {
+                if (heads[column] < columns[column].size() && columns[column].startTimes[heads[column]] == time)
+                {
+                    ++heads[column];
+                    ++chordSize;
+                    chordColumn = column;
+                }
+            }
+
+            ++result.chordSizes[chordSize];
+            if (chordSize == 1)
+                runs.add(chordColumn, time);
+            else
+                runs.breakRuns();
+        }
+    }
+
+    /*Density and hold coverage over the whole map*/
+    ActiveSpans spans;
+    for (auto const& notes : columns)
+    {
+        spans.startTimes.insert(spans.startTimes.end(), notes.startTimes.cbegin(), notes.startTimes.cend());
+        spans.endTimes.insert(spans.endTimes.end(), notes.endTimes.cbegin(), notes.endTimes.cend());
+    }
+    std::sort(spans.startTimes.begin(), spans.startTimes.end());
+    std::sort(spans.endTimes.begin(), spans.endTimes.end());
+
+    auto const firstTime = spans.startTimes.front();
+    auto const lastTime = spans.endTimes.back();
+    auto const curve = ComputeNpsCurve(spans.startTimes, spans.endTimes, firstTime, lastTime, DensityOptions{}.windowSize, DensityOptions{}.step);
+    if (!curve.empty())
+        result.peakNotesPerSecond = *std::max_element(curve.cbegin(), curve.cend());
+
+    if (!holds.empty() && lastTime > firstTime)
+    {
+        std::sort(holds.begin(), holds.end());
+        int covered{};
+        auto [start, end] = holds.front();
+        for (auto const& [holdStart, holdEnd] : holds)
+        {
+            if (holdStart > end)
+            {
+                covered += end - start;
+                start = holdStart;
+            }
+            end = std::max(end, holdEnd);
+        }
+        covered += end - start;
+        result.holdCoverage = covered / static_cast<float>(lastTime - firstTime);
+    }
+    return result;
+}
+
+Analyze::ManiaAnalysis Analyze::AnalyzeMania(OsuFile const& beatmap, ManiaAnalyzerOptions const& options)
+{
+    return AnalyzeMania(SplitColumns(beatmap), options);
+}
+
+std::ostream& Analyze::operator<<(std::ostream& os, ManiaAnalysis const& analysis)
+{
+    os << analysis.keyCount << "K, " << analysis.noteCount << " notes, " << analysis.holdCount << " holds\n";
+
+    os << "\tcolumns:";
+    for (int i = 0; i < analysis.keyCount; ++i)
+        os << "   " << analysis.getPercentOfColumn(i) * 100.f << '%';
+
+    os << "\n\tjacks:";
+    for (int i = 0; i < analysis.keyCount; ++i)
+        os << "   " << analysis.jackCounts[i] << " (min " << analysis.minJackGaps[i] << "ms)";
+
+    os << "\n\tchords:";
+    for (size_t size = 1; size < analysis.chordSizes.size(); ++size)
+    {
+        if (analysis.chordSizes[size] != 0)
+            os << "   " << size << " x " << analysis.chordSizes[size];
+    }
+
+    os << "\n\t" << analysis.trillCount << " trills (" << analysis.trillNotes << " notes), "
+        << analysis.rollCount << " rolls (" << analysis.rollNotes << " notes)"
+        << "\n\tleft hand " << analysis.getHandBalance() * 100.f << "%, hold coverage " << analysis.holdCoverage * 100.f
+        << "%, peak " << analysis.peakNotesPerSecond << " notes/s\n";
+    return os;
+}
@@ -0,0 +1,74 @@
+#include "include/Snap.hpp"
+#include "include/TimingSweep.hpp"
+#include <limits>
+#include <numeric>
+#include <algorithm>
+
+std::ostream& Analyze::operator<<(std::ostream& os, SnapDivisor snap)
+{
+    if (snap == SnapDivisor::Unsnapped)
+        os << "Unsnapped";
+    else
+        os << "1/" << static_cast<int>(snap);
+    return os;
+}
+
+/**
+ * @brief Signed distance in milliseconds from `beats` to the nearest 1/divisor tick
+ */
+static double GetTickError(double beats, double beatLength, int divisor)
+{
+    auto const ticks = beats * divisor;
+    return (ticks - std::round(ticks)) * beatLength / divisor;
+}
+
+Analyze::SnapReport Analyze::ClassifySnaps(
+    std::vector<std::unique_ptr<HitObject>> const& hitObjects,
+    std::vector<TimingPoint> const& timingPoints,
+    SnapOptions const& options)
+{
+    constexpr SnapDivisor divisors[]{ SnapDivisor::Whole, SnapDivisor::Half, SnapDivisor::Third, SnapDivisor::Quarter, SnapDivisor::Sixth, SnapDivisor::Eighth };
+
+    SnapReport report;
+    report.snaps.resize(hitObjects.size(), SnapDivisor::Unsnapped);
+    report.offsetErrors.resize(hitObjects.size());
+
+    /*The sweep only moves forward, so unsorted objects, such as those of a converted map, are walked in time order*/
+    std::vector<size_t> order(hitObjects.size());
+    std::iota(order.begin(), order.end(), 0);
+    if (!std::is_sorted(hitObjects.cbegin(), hitObjects.cend(), [](auto const& lhs, auto const& rhs) { return lhs->time < rhs->time; }))
+        std::stable_sort(order.begin(), order.end(), [&hitObjects](size_t lhs, size_t rhs) { return hitObjects[lhs]->time < hitObjects[rhs]->time; });
+
+    TimingSweep sweep{ timingPoints };
+    for (auto const i : order)
+    {
+        auto const time = hitObjects[i]->time;
+        sweep.advanceTo(time);
+        auto const beatLength = sweep.getBeatLength();
+        auto const beats = (time - sweep.getOffset()) / beatLength;
+
+        auto nearestError = std::numeric_limits<double>::max();
+        for (auto const divisor : divisors)
+        {
+            auto const error = GetTickError(beats, beatLength, static_cast<int>(divisor));
+            if (std::abs(error) <= options.tolerance)
+            {
+                report.snaps[i] = divisor;
+                nearestError = error;
+                break;
+            }
+            if (std::abs(error) < std::abs(nearestError))
+                nearestError = error;
+        }
+
+        report.offsetErrors[i] = static_cast<float>(nearestError);
+        if (report.snaps[i] == SnapDivisor::Unsnapped)
+            report.unsnapped.push_back(UnsnappedObject{ i, time, static_cast<float>(nearestError) });
+    }
+    return report;
+}
+
+Analyze::SnapReport Analyze::ClassifySnaps(OsuFile const& beatmap, SnapOptions const& options)
+{
+    return ClassifySnaps(beatmap.hitObjects, beatmap.timingPoints, options);
+}
@@ -0,0 +1,130 @@
+/*****************************************************************//**
+ * \file   Density.hpp
+ * \brief  Note density (notes per second) over time
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include <array>
+
+namespace Analyze
+{
+    /**
+     * @brief The times of the last `N` notes, kept in a ring buffer
+     * @details Used for the running density of the converter, where the oldest note is dropped for every new one.
+     */
+    template<size_t N>
+    class RecentNoteTimes
+    {
+        std::array<int, N> times{};
+        size_t head = 0;
+        size_t count = 0;
+    public:
+        void push(int time)
+        {
+            times[(head + count) % N] = time;
+            if (count == N)
+                head = (head + 1) % N;
+            else
+                ++count;
+        }
+
+        [[nodiscard]] size_t size() const { return count; }
+
+        /**
+         * @brief The oldest recorded time
+         */
+        [[nodiscard]] int front() const { return times[head]; }
+
+        /**
+         * @brief The latest recorded time
+         */
+        [[nodiscard]] int back() const { return times[(head + count - 1) % N]; }
+
+        /**
+         * @brief Average time between the recorded notes, in milliseconds
+         * @note Requires at least 2 recorded notes
+         */
+        [[nodiscard]] double getDensity() const
+        {
+            return (back() - front()) / static_cast<double>(count);
+        }
+    };
+
+    /**
+     * @brief The time spans where each hit object is active
+     * @details Circles are active at their start time only, holds, sliders and spinners until their end time.
+     * Both arrays are sorted separately, so `startTimes[i]` and `endTimes[i]` may belong to different objects.
+     */
+    struct ActiveSpans
+    {
+        std::vector<int> startTimes;
+        std::vector<int> endTimes;
+
+        [[nodiscard]] auto size() const { return startTimes.size(); }
+    };
+
+    [[nodiscard]] ActiveSpans GetActiveSpans(OsuFile const& beatmap);
+
+    /**
+     * @brief Count the active objects in every window [t, t + windowSize) for t = firstTime, firstTime + step, ... <= lastTime
+     * @param sortedStartTimes Object start times in ascending order
+     * @param sortedEndTimes Object end times in ascending order
+     * @return Notes per second of each window
+     * @details An object is counted in a window when it starts before the window ends and ends at or after the window starts.
+     * Both arrays are walked once with a pointer each, so this is O(objects + windows).
+     */
+    [[nodiscard]] std::vector<float> ComputeNpsCurve(
+        std::vector<int> const& sortedStartTimes,
+        std::vector<int> const& sortedEndTimes,
+        int firstTime,
+        int lastTime,
+        int windowSize,
+        int step
+    );
+
+    struct DensityOptions
+    {
+        /**
+         * @brief Size of the sliding window in milliseconds
+         */
+        int windowSize = 1'000;
+
+        /**
+         * @brief Distance between the starts of 2 windows in milliseconds
+         */
+        int step = 250;
+    };
+
+    struct DensityAnalysis
+    {
+        DensityOptions options;
+
+        /**
+         * @brief Start time of the first window
+         */
+        int startTime{};
+
+        /**
+         * @brief Notes per second of each window
+         */
+        std::vector<float> curve;
+
+        float peak{};
+
+        /**
+         * @brief Objects per second of drain time, where drain time excludes breaks
+         */
+        float drainNormalized{};
+
+        /**
+         * @brief Get the notes per second that `percent` of all windows are at or below
+         * @param percent In [0, 100]
+         */
+        [[nodiscard]] float getPercentile(float percent) const;
+    };
+
+    [[nodiscard]] DensityAnalysis AnalyzeDensity(OsuFile const& beatmap, DensityOptions const& options = {});
+}
@@ -0,0 +1,192 @@
+/*****************************************************************//**
+ * \file   JumpAnalyzer.hpp
+ * \brief  Measure jump and stream content of osu!standard beatmaps
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include <array>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+
+namespace Analyze
+{
+    /**
+     * @brief What a pair of consecutive hit objects is part of
+     */
+    enum class PairType : std::uint8_t
+    {
+        /**
+         * @brief Spinners, and pairs too far apart in time to be part of any pattern
+         */
+        None,
+
+        /**
+         * @brief The 2 objects are (almost) on top of each other
+         */
+        Stack,
+
+        /**
+         * @brief A short run of 1/4 notes
+         */
+        Burst,
+
+        /**
+         * @brief A long run of 1/4 notes
+         */
+        Stream,
+
+        /**
+         * @brief A widely spaced 1/2 pair, aka. a 1-2 jump
+         */
+        Jump,
+
+        Count
+    };
+
+    std::ostream& operator<<(std::ostream& os, PairType type);
+
+    struct JumpAnalyzerOptions
+    {
+        /**
+         * @brief Pairs closer than this (in osu!pixels) are stacks
+         */
+        float stackDistance = 3.f;
+
+        /**
+         * @brief 1/2 pairs spaced at least this (in osu!pixels) are jumps
+         */
+        float jumpDistance = 110.f;
+
+        /**
+         * @brief Runs of 1/4 notes with at least this many objects are streams, shorter ones (of at least 3) are bursts
+         */
+        int minStreamObjects = 9;
+
+        /**
+         * @brief Allowed timing error in milliseconds when snapping a pair's time delta to 1/4 or 1/2 beat
+         */
+        double snapTolerance = 5.0;
+
+        /**
+         * @brief Length of each histogram section, in beats
+         */
+        int sectionLengthInBeats = 16;
+    };
+
+    /**
+     * @brief Measurements of every consecutive object pair, stored as parallel arrays
+     * @details Element `i` describes the pair (object `i`, object `i + 1`)
+     */
+    struct PairMeasurements
+    {
+        std::vector<float> distance;
+        std::vector<float> timeDelta;
+
+        /**
+         * @brief Direction of the movement from the first object to the second, in degrees [-180, 180]
+         */
+        std::vector<float> angle;
+
+        /**
+         * @brief Distance over time delta, in osu!pixels per millisecond
+         */
+        std::vector<float> velocity;
+
+        /**
+         * @brief BPM of the timing section the pair starts in
+         */
+        std::vector<float> bpm;
+
+        std::vector<PairType> type;
+
+        [[nodiscard]] auto size() const { return type.size(); }
+    };
+
+    struct SectionHistogram
+    {
+        constexpr static inline auto DistanceBinWidth = 50;
+        constexpr static inline auto DistanceBins = 8;
+
+        /**
+         * @brief Start time of the section in milliseconds
+         */
+        int startTime{};
+
+        std::array<int, static_cast<size_t>(PairType::Count)> types{};
+
+        /**
+         * @brief Pair distances in bins of `DistanceBinWidth` osu!pixels, the last bin holds everything further
+         */
+        std::array<int, DistanceBins> distances{};
+    };
+
+    struct JumpSummary
+    {
+        int objectCount{};
+        std::array<int, static_cast<size_t>(PairType::Count)> pairCounts{};
+
+        float averageJumpDistance{};
+        float maxJumpVelocity{};
+
+        /**
+         * @brief Highest BPM of all timing sections that contain a jump
+         */
+        float maxJumpBPM{};
+    };
+
+    struct JumpAnalysis
+    {
+        PairMeasurements pairs;
+        JumpSummary summary;
+        std::vector<SectionHistogram> sections;
+
+        /**
+         * @brief Fraction of all pairs that are `type` and are in timing sections at least `minBPM`
+         */
+        [[nodiscard]] float getPercentOf(PairType type, float minBPM = 0.f) const;
+    };
+
+    /**
+     * @brief Measure and classify every consecutive object pair of an osu!standard map
+     * @param hitObjects Hit objects sorted by time
+     * @param timingPoints Timing points sorted by time
+     */
+    [[nodiscard]] JumpAnalysis AnalyzeJumps(
+        std::vector<std::unique_ptr<HitObject>> const& hitObjects,
+        std::vector<TimingPoint> const& timingPoints,
+        JumpAnalyzerOptions const& options = {}
+    );
+
+    [[nodiscard]] JumpAnalysis AnalyzeJumps(OsuFile const& beatmap, JumpAnalyzerOptions const& options = {});
+
+    std::ostream& operator<<(std::ostream& os, JumpSummary const& summary);
+
+    struct LibraryEntry
+    {
+        std::filesystem::path path;
+        JumpSummary summary;
+
+        /**
+         * @brief Same as `JumpAnalysis::getPercentOf(PairType::Jump, minBPM)`, kept so that the pair arrays can be dropped
+         */
+        float jumpPercentAtMinBPM{};
+    };
+
+    /**
+     * @brief Analyze every osu!standard beatmap under `root` (including sub-directories) in parallel
+     * @details Only the [General], [TimingPoints] and [HitObjects] sections are parsed.
+     * Beatmaps of other game modes are skipped, and those that fail to parse are reported as warnings and skipped.
+     * @param minBPM BPM threshold used for `LibraryEntry::jumpPercentAtMinBPM`
+     * @param filter Only beatmaps passing the filter are returned, if set
+     */
+    [[nodiscard]] std::vector<LibraryEntry> AnalyzeLibrary(
+        std::filesystem::path const& root,
+        float minBPM = 0.f,
+        std::function<bool(LibraryEntry const&)> const& filter = {},
+        JumpAnalyzerOptions const& options = {}
+    );
+}
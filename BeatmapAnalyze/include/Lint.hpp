@@ -0,0 +1,97 @@
+/*****************************************************************//**
+ * \file   Lint.hpp
+ * \brief  Find mistakes in (converted) beatmaps
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include <array>
+#include <cstdint>
+
+namespace Analyze
+{
+    enum class LintCheck : std::uint8_t
+    {
+        /**
+         * @brief The hit object starts before the previous one in the file
+         */
+        Unsorted,
+
+        /**
+         * @brief The note starts before the previous note of its column has ended
+         */
+        Overlap,
+
+        /**
+         * @brief The hold ends before it starts
+         */
+        ReversedHold,
+
+        /**
+         * @brief The hit object is (partly) inside a break period
+         */
+        InBreak,
+
+        /**
+         * @brief The hold is shorter than the minimum length
+         */
+        ShortHold,
+
+        Count
+    };
+
+    std::ostream& operator<<(std::ostream& os, LintCheck check);
+
+    struct LintOptions
+    {
+        /**
+         * @brief Holds shorter than `beatLength / minHoldDivisor` are reported
+         */
+        int minHoldDivisor = 32;
+    };
+
+    struct LintIssue
+    {
+        LintCheck check;
+
+        /**
+         * @brief Index in the hit objects
+         */
+        size_t index;
+
+        int time;
+
+        /**
+         * @brief Column in osu!mania maps, -1 for other modes
+         */
+        int column;
+    };
+
+    std::ostream& operator<<(std::ostream& os, LintIssue const& issue);
+
+    struct LintReport
+    {
+        /**
+         * @brief Issues in time order
+         */
+        std::vector<LintIssue> issues;
+
+        std::array<int, static_cast<size_t>(LintCheck::Count)> counts{};
+
+        [[nodiscard]] bool empty() const { return issues.empty(); }
+
+        [[nodiscard]] int getCount(LintCheck check) const { return counts[static_cast<size_t>(check)]; }
+    };
+
+    std::ostream& operator<<(std::ostream& os, LintReport const& report);
+
+    /**
+     * @brief Run every check in one time-ordered sweep over the hit objects
+     * @details Each column keeps the end time of its last note, the breaks and timing points are walked
+     * with a cursor each, so the cost is linear unless the objects are unsorted and need to be ordered first.
+     * Column checks only run on osu!mania maps.
+     */
+    [[nodiscard]] LintReport Lint(OsuFile const& beatmap, LintOptions const& options = {});
+}
@@ -0,0 +1,135 @@
+/*****************************************************************//**
+ * \file   ManiaAnalyzer.hpp
+ * \brief  Pattern statistics of osu!mania beatmaps
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+
+namespace Analyze
+{
+    /**
+     * @brief The notes of one column, sorted by start time
+     * @details For circles, the end time is the same as the start time.
+     */
+    struct ColumnNotes
+    {
+        std::vector<int> startTimes;
+        std::vector<int> endTimes;
+
+        [[nodiscard]] auto size() const { return startTimes.size(); }
+
+        [[nodiscard]] bool isHold(size_t index) const { return endTimes[index] > startTimes[index]; }
+
+        void add(int startTime, int endTime)
+        {
+            startTimes.push_back(startTime);
+            endTimes.push_back(endTime);
+        }
+    };
+
+    /**
+     * @brief Split the hit objects of an osu!mania map into columns, computing every object's column once
+     */
+    [[nodiscard]] std::vector<ColumnNotes> SplitColumns(OsuFile const& beatmap);
+
+    /**
+     * @brief Split osu!mania hit objects of `keyCount` columns, for notes that are not part of an `OsuFile` yet
+     */
+    [[nodiscard]] std::vector<ColumnNotes> SplitColumns(std::vector<std::unique_ptr<HitObject>> const& hitObjects, int keyCount);
+
+    struct ManiaAnalyzerOptions
+    {
+        /**
+         * @brief 2 notes in the same column this close (start to start, in milliseconds) are a jack
+         */
+        int maxJackGap = 200;
+
+        /**
+         * @brief Maximum time between 2 notes in milliseconds for them to be part of the same trill or roll
+         */
+        int maxPatternGap = 200;
+
+        /**
+         * @brief Minimum number of notes for a trill or roll
+         */
+        int minPatternNotes = 4;
+    };
+
+    struct ManiaAnalysis
+    {
+        int keyCount{};
+        int noteCount{};
+        int holdCount{};
+
+        /**
+         * @brief Number of notes in each column
+         */
+        std::vector<int> columnCounts;
+
+        /**
+         * @brief Number of jacks in each column
+         */
+        std::vector<int> jackCounts;
+
+        /**
+         * @brief Smallest time between 2 consecutive notes of each column, -1 if the column has less than 2 notes
+         */
+        std::vector<int> minJackGaps;
+
+        /**
+         * @brief `chordSizes[n]` is the number of rows with exactly n notes starting at the same time
+         */
+        std::vector<int> chordSizes;
+
+        /**
+         * @brief Number of trills (alternating between 2 columns) and the notes in them
+         */
+        int trillCount{};
+        int trillNotes{};
+
+        /**
+         * @brief Number of rolls (moving 1 column at a time in one direction) and the notes in them
+         */
+        int rollCount{};
+        int rollNotes{};
+
+        /**
+         * @brief Notes played by each hand, the middle column of odd keys is not counted
+         */
+        int leftHandNotes{};
+        int rightHandNotes{};
+
+        /**
+         * @brief Fraction of the map's length where at least one hold is held
+         */
+        float holdCoverage{};
+
+        float peakNotesPerSecond{};
+
+        /**
+         * @brief Fraction of notes (of both hands) played by the left hand
+         */
+        [[nodiscard]] float getHandBalance() const
+        {
+            auto const total = leftHandNotes + rightHandNotes;
+            return total == 0 ? 0.5f : leftHandNotes / static_cast<float>(total);
+        }
+
+        /**
+         * @brief Fraction of notes in `column`
+         */
+        [[nodiscard]] float getPercentOfColumn(int column) const
+        {
+            return noteCount == 0 ? 0.f : columnCounts[column] / static_cast<float>(noteCount);
+        }
+    };
+
+    [[nodiscard]] ManiaAnalysis AnalyzeMania(std::vector<ColumnNotes> const& columns, ManiaAnalyzerOptions const& options = {});
+
+    [[nodiscard]] ManiaAnalysis AnalyzeMania(OsuFile const& beatmap, ManiaAnalyzerOptions const& options = {});
+
+    std::ostream& operator<<(std::ostream& os, ManiaAnalysis const& analysis);
+}
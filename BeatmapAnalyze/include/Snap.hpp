@@ -0,0 +1,94 @@
+/*****************************************************************//**
+ * \file   Snap.hpp
+ * \brief  Classify the beat snap of hit objects
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include <cstdint>
+
+namespace Analyze
+{
+    /**
+     * @brief The coarsest beat division a hit object is on, the value is the divisor
+     */
+    enum class SnapDivisor : std::uint8_t
+    {
+        Unsnapped = 0,
+        Whole = 1,
+        Half = 2,
+        Third = 3,
+        Quarter = 4,
+        Sixth = 6,
+        Eighth = 8
+    };
+
+    std::ostream& operator<<(std::ostream& os, SnapDivisor snap);
+
+    struct SnapOptions
+    {
+        /**
+         * @brief Maximum distance in milliseconds from a tick for an object to be snapped to it
+         * @details Object times are stored as integers, so anything below 1ms would report rounding as unsnapped.
+         */
+        double tolerance = 2.0;
+    };
+
+    struct UnsnappedObject
+    {
+        /**
+         * @brief Index in the hit objects
+         */
+        size_t index;
+
+        int time;
+
+        /**
+         * @brief Signed distance in milliseconds to the nearest tick of any divisor
+         */
+        float offsetError;
+    };
+
+    struct SnapReport
+    {
+        /**
+         * @brief Snap of every hit object, in the same order as the hit objects
+         */
+        std::vector<SnapDivisor> snaps;
+
+        /**
+         * @brief Signed distance in milliseconds of every hit object to the tick it is snapped to,
+         * or to the nearest tick of any divisor if it's unsnapped
+         */
+        std::vector<float> offsetErrors;
+
+        /**
+         * @brief In time order
+         */
+        std::vector<UnsnappedObject> unsnapped;
+
+        /**
+         * @brief Number of objects snapped to `snap`
+         */
+        [[nodiscard]] int getCount(SnapDivisor snap) const
+        {
+            return static_cast<int>(std::count(snaps.cbegin(), snaps.cend(), snap));
+        }
+    };
+
+    /**
+     * @brief Classify the snap of every hit object against its uninherited timing point
+     * @param hitObjects Hit objects, walked in time order if they are not sorted by time
+     * @param timingPoints Timing points sorted by time
+     * @details Objects and timing points are walked together, so it's a single linear pass once the objects are sorted.
+     */
+    [[nodiscard]] SnapReport ClassifySnaps(
+        std::vector<std::unique_ptr<HitObject>> const& hitObjects,
+        std::vector<TimingPoint> const& timingPoints,
+        SnapOptions const& options = {}
+    );
+
+    [[nodiscard]] SnapReport ClassifySnaps(OsuFile const& beatmap, SnapOptions const& options = {});
+}
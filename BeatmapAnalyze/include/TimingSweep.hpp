@@ -0,0 +1,97 @@
+/*****************************************************************//**
+ * \file   TimingSweep.hpp
+ * \brief  A forward-only cursor over the timing points of a beatmap
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+
+namespace Analyze
+{
+    /**
+     * @brief Tracks the timing point state in effect while walking a beatmap in time order
+     * @details Hit objects and timing points are both sorted by time, so instead of searching the
+     * timing points for every object, the cursor is advanced together with the objects.
+     * Walking a whole map therefore costs O(objects + timing points).
+     */
+    class TimingSweep
+    {
+    public:
+        TimingSweep(std::vector<TimingPoint> const& timingPoints) : timingPoints{ timingPoints }
+        {
+            /*Objects before the first uninherited timing point are timed by the first one, as osu! does*/
+            if (auto const first = std::find_if(timingPoints.cbegin(), timingPoints.cend(), [](TimingPoint const& point) { return point.uninherited; });
+                first != timingPoints.cend())
+            {
+                beatLength = first->beatLength;
+                offset = first->time;
+                meter = first->meter;
+            }
+        }
+
+        /**
+         * @brief Apply every timing point up to (and including) `time`
+         * @note `time` should not decrease between calls
+         */
+        TimingSweep& advanceTo(int time)
+        {
+            while (next < timingPoints.size() && timingPoints[next].time <= time)
+            {
+                auto const& point = timingPoints[next++];
+                if (point.uninherited)
+                {
+                    beatLength = point.beatLength;
+                    offset = point.time;
+                    meter = point.meter;
+                    sliderVelocity = 1.0;
+                }
+                else if (point.beatLength < 0)
+                    sliderVelocity = 100.0 / std::clamp(-point.beatLength, 10.f, 1000.f);
+                effects = point.effects;
+            }
+            return *this;
+        }
+
+        /**
+         * @brief Duration of a beat in milliseconds, from the active uninherited timing point
+         */
+        [[nodiscard]] double getBeatLength() const { return beatLength; }
+
+        /**
+         * @brief Start time of the active uninherited timing point, which is where beat 0 is
+         */
+        [[nodiscard]] int getOffset() const { return offset; }
+
+        [[nodiscard]] int getMeter() const { return meter; }
+
+        /**
+         * @brief Slider velocity multiplier from the active inherited timing point
+         */
+        [[nodiscard]] double getSliderVelocity() const { return sliderVelocity; }
+
+        [[nodiscard]] double getBPM() const { return 60'000 / beatLength; }
+
+        [[nodiscard]] bool isKiai() const { return effects & static_cast<unsigned>(TimingPoint::Effect::Kiai); }
+
+        /**
+         * @brief End time of a slider starting at the current position of the cursor
+         * @param sliderMultiplier Should be parsed from `Difficulty::sliderMultiplier`
+         */
+        [[nodiscard]] double getSliderEndTime(Slider const& slider, float sliderMultiplier) const
+        {
+            return slider.time + slider.getDuration(sliderMultiplier, static_cast<float>(beatLength / sliderVelocity));
+        }
+
+    private:
+        std::vector<TimingPoint> const& timingPoints;
+        size_t next = 0;
+
+        double beatLength = 500.0;
+        double sliderVelocity = 1.0;
+        int offset = 0;
+        int meter = 4;
+        unsigned effects = 0;
+    };
+}
@@ -1,27 +1,42 @@
 #include "include/BeatmapConvert.hpp"
 #include <algorithm>
 #include <cassert>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <future>
 #include "RandomEngine.hpp"
-
-
-Mania::HitObjectPatternGenerator::HitObjectPatternGenerator(
+#include "DirectoryWalker.hpp"
+#include "include/Manifest.hpp"
+#include "include/ConversionCache.hpp"
+#include "include/Admission.hpp"
+#include <iterator>
+#include <sstream>
+#include "BeatmapAnalyze/include/Snap.hpp"
+#include "BeatmapAnalyze/include/ManiaAnalyzer.hpp"
+#include "BeatmapAnalyze/include/Lint.hpp"
+
+
+template<int KeyCount>
+Mania::HitObjectPatternGenerator<KeyCount>::HitObjectPatternGenerator(
     HitObject const& hitObject, 
     OsuFile& beatmap, 
-    Pattern&& previousPattern, 
+    PatternSummary const& previousPattern, 
     int previousTime, 
     Coord previousPosition, 
     double density, 
     Pattern::Type lastStair, 
-    OsuFile const& originalBeatmap,
-    int totalColumns
+    ConversionContext const& context,
+    int hitObjectIndex,
+    HitObjectContext const& objectContext,
+    int totalColumns,
+    RandomEngine& random
 )
     : 
-    PatternGenerator(std::move(previousPattern), hitObject, originalBeatmap, totalColumns),
+    Base(previousPattern, hitObject, context, hitObjectIndex, objectContext, totalColumns, random),
     beatmap{beatmap},
     stairType{lastStair}
 {
-    auto const& timingPoint = originalBeatmap.getTimingPointAt<TimingPoint::Type::TimingControlPoint>(hitObject.time);
-
     
     Coord const positionData{ hitObject.x, hitObject.y };
     
@@ -36,8 +51,8 @@ Mania::HitObjectPatternGenerator::HitObjectPatternGenerator(
     else if (timeSeparation <= 125) convertTypeFlag |= Pattern::Type::ForceNotStack;
     else if (timeSeparation <= 135 && positionSeparation < 20) convertTypeFlag |= Pattern::Type::Cycle | Pattern::Type::KeepSingle;
     else if (timeSeparation <= 150 && positionSeparation < 20) convertTypeFlag |= Pattern::Type::ForceStack | Pattern::Type::LowProbability;
-    else if (positionSeparation < 20 && density >= timingPoint.beatLength / 2.5) convertTypeFlag |= Pattern::Type::Reverse | Pattern::Type::LowProbability;
-    else if (density < timingPoint.beatLength / 2.5 || timingPoint.effects & static_cast<unsigned>(TimingPoint::Effect::Kiai))
+    else if (positionSeparation < 20 && density >= objectContext.beatLength / 2.5) convertTypeFlag |= Pattern::Type::Reverse | Pattern::Type::LowProbability;
+    else if (density < objectContext.beatLength / 2.5 || objectContext.kiai)
     {
         // High density
     }
@@ -54,10 +69,11 @@ Mania::HitObjectPatternGenerator::HitObjectPatternGenerator(
 
 //#define PrintDetail
 
-Mania::Pattern Mania::HitObjectPatternGenerator::generate()
+template<int KeyCount>
+Mania::Pattern Mania::HitObjectPatternGenerator<KeyCount>::generate()
 {
 #ifdef PrintDetail
-    std::cout << "original: " << hitObject.time << ", type: " << hitObject.type << " -> convertType: " << convertType << '\n';
+    Log(LogLevel::Debug, "original: ", hitObject.time, ", type: ", hitObject.type, " -> convertType: ", convertType);
 #endif
 
     auto generateCore = [this]()->Pattern 
@@ -69,9 +85,9 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generate()
             return pattern;
         }
 
-        int const lastColumn = previousPattern.hitObjects.empty() ? 0 : previousPattern.hitObjects.front()->getColumnIndex(totalColumns);
+        int const lastColumn = previousPattern.empty() ? 0 : previousPattern.firstColumn;
 
-        if ((convertType & Pattern::Type::Reverse) && !previousPattern.hitObjects.empty())
+        if ((convertType & Pattern::Type::Reverse) && !previousPattern.empty())
         {
             for (int i = randomStart; i < totalColumns; ++i)
             {
@@ -82,7 +98,7 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generate()
         }
 
         if (convertType & Pattern::Type::Cycle
-            && previousPattern.hitObjects.size() == 1
+            && previousPattern.noteCount == 1
             && (totalColumns != 8 || lastColumn != 0)
             && (totalColumns % 2 == 0 || lastColumn != totalColumns / 2)
             )
@@ -92,7 +108,7 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generate()
             return pattern;
         }
 
-        if (convertType & Pattern::Type::ForceStack && !previousPattern.hitObjects.empty())
+        if (convertType & Pattern::Type::ForceStack && !previousPattern.empty())
         {
             for (int i = randomStart; i < totalColumns; ++i)
             {
@@ -102,7 +118,7 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generate()
             return pattern;
         }
 
-        if (previousPattern.hitObjects.size() == 1)
+        if (previousPattern.noteCount == 1)
         {
             if (convertType & Pattern::Type::Stair)
             {
@@ -171,52 +187,40 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generate()
 
     auto p = generateCore();
 
-    for (auto const& obj : p.hitObjects)
+    for (auto const& note : p.notes)
     {
-        if ((convertType & Pattern::Type::Stair) && obj->getColumnIndex(totalColumns) == totalColumns - 1)
+        if ((convertType & Pattern::Type::Stair) && note.column == totalColumns - 1)
             stairType = Pattern::Type::ReverseStair;
-        if ((convertType & Pattern::Type::ReverseStair) && obj->getColumnIndex(totalColumns) == randomStart)
+        if ((convertType & Pattern::Type::ReverseStair) && note.column == randomStart)
             stairType = Pattern::Type::Stair;
 
     }
 #ifdef PrintDetail
-    for (auto const& obj : p.hitObjects)
-        std::cout <<obj->getColumnIndex(totalColumns) << " : " << *obj << '\n';
+    for (auto const& note : p.notes)
+        Log(LogLevel::Debug, note.column, " : ", note.startTime);
 #endif
     return p;
 }
 
 
-void Mania::HitObjectPatternGenerator::addToPattern(Pattern& pattern, int column) const
+template<int KeyCount>
+void Mania::HitObjectPatternGenerator<KeyCount>::addToPattern(Pattern& pattern, int column) const
 {
-    //pattern += std::make_unique<Circle>(HitObject::ColumnToX(column, totalColumns), 0, hitObject->time, hitObject->hitSample);
-    pattern += Circle::MakeManiaHitObject(column, totalColumns, hitObject.time, hitObject.hitSound, hitObject.hitSample);
+    pattern += ManiaNote{ column, hitObject.time, hitObject.time, hitObject.hitSound, true };
 }
 
-bool Mania::HitObjectPatternGenerator::hasSpecialColumn() const
+template<int KeyCount>
+bool Mania::HitObjectPatternGenerator<KeyCount>::hasSpecialColumn() const
 {
     return 
         hitObject.hitSound == HitObject::HitSound::Clap &&
         hitObject.hitSound == HitObject::HitSound::Finish;
 }
 
-int Mania::HitObjectPatternGenerator::getNextColumn(int last) const
-{
-    if (convertType & Pattern::Type::Gathered)
-    {
-        ++last;
-        if (last == totalColumns)
-            last = randomStart;
-    }
-    else
-        last = getRandomColumn();
-
-    return last;
-}
-
 
 
-Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomNotes(int noteCount) const
+template<int KeyCount>
+Mania::Pattern Mania::HitObjectPatternGenerator<KeyCount>::generateRandomNotes(int noteCount) const
 {
     Pattern pattern{ totalColumns };
     auto const allowStacking = !(convertType & Pattern::Type::ForceNotStack);
@@ -226,25 +230,23 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomNotes(int noteCou
 
     auto nextColumn = hitObject.getColumnIndex(totalColumns);
 
-    auto getNextColumn = [this](int last)
+    /*Gathered notes go to the next free column, others to a random free column*/
+    auto const findColumn = [this](int column, std::initializer_list<std::uint32_t> occupiedColumns)
     {
-        if (convertType & Pattern::Type::Gathered)
-        {
-            ++last;
-            if (last == totalColumns)
-                last = randomStart;
-        }
-        else
-            last = getRandomColumn();
-        return last;
+        return convertType & Pattern::Type::Gathered
+            ? findAvailableColumn(column, {}, {}, CyclicColumn{}, AnyColumn{}, occupiedColumns)
+            : findAvailableColumn(column, {}, {}, RandomColumn{}, AnyColumn{}, occupiedColumns);
     };
 
     for (int i = 0; i < noteCount; ++i)
     {
         nextColumn = allowStacking
-            ? findAvailableColumn(nextColumn, {}, {}, getNextColumn, {}, { &pattern })
-            : findAvailableColumn(nextColumn, {}, {}, getNextColumn, {}, { &pattern, &previousPattern });
+            ? findColumn(nextColumn, { pattern.columnMask })
+            : findColumn(nextColumn, { pattern.columnMask, previousPattern.columnMask });
 
+        /*No free column left*/
+        if (nextColumn == -1)
+            break;
         addToPattern(pattern, nextColumn);
     }
 
@@ -252,9 +254,10 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomNotes(int noteCou
 
 }
 
-int Mania::HitObjectPatternGenerator::getRandomNoteCount(double p2, double p3, double p4, double p5) const
+template<int KeyCount>
+int Mania::HitObjectPatternGenerator<KeyCount>::getRandomNoteCount(double p2, double p3, double p4, double p5) const
 {
-    switch (previousPattern.totalColumn)
+    switch (totalColumns)
     {
         case 2:
             p2 = 0;
@@ -287,12 +290,13 @@ int Mania::HitObjectPatternGenerator::getRandomNoteCount(double p2, double p3, d
     if (hitObject.hitSound == HitObject::HitSound::Clap)
         p2 = 1;
 
-    return GetRandomNoteCount(p2, p3, p4, p5);
+    return GetRandomNoteCount(random, p2, p3, p4, p5);
 }
 
-int Mania::HitObjectPatternGenerator::getRandomNoteCountMirrored(double centreProbability, double p2, double p3, bool& addToCentre)
+template<int KeyCount>
+int Mania::HitObjectPatternGenerator<KeyCount>::getRandomNoteCountMirrored(double centreProbability, double p2, double p3, bool& addToCentre)
 {
-    auto const column = previousPattern.totalColumn;
+    auto const column = totalColumns;
     switch (column)
     {
     case 2:
@@ -338,15 +342,16 @@ int Mania::HitObjectPatternGenerator::getRandomNoteCountMirrored(double centrePr
     p2 = std::clamp(p2, 0., 1.);
     p3 = std::clamp(p3, 0., 1.);
 
-    auto centreVal = RandomEngine::getRand<double>();
-    int noteCount = GetRandomNoteCount(p2, p3);
+    auto centreVal = random.getRand();
+    int noteCount = GetRandomNoteCount(random, p2, p3);
 
     addToCentre = column % 2 != 0 && noteCount != 3 && centreVal > 1 - centreProbability;
     return noteCount;
 }
 
 
-Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomPatternWithMirrored(double centreProbability, double p2, double p3)
+template<int KeyCount>
+Mania::Pattern Mania::HitObjectPatternGenerator<KeyCount>::generateRandomPatternWithMirrored(double centreProbability, double p2, double p3)
 {
     if(convertType & Pattern::Type::ForceNotStack)
         return generateRandomPattern(1 / 2.f + p2 / 2, p2, (p2 + p3) / 2, p3);
@@ -362,7 +367,9 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomPatternWithMirror
 
     for (int i = 0; i < noteCount; ++i)
     {
-        nextColumn = findAvailableColumn(nextColumn, {}, columnLimit, {}, {}, { &pattern });
+        nextColumn = findAvailableColumn(nextColumn, {}, columnLimit, {}, {}, { pattern.columnMask });
+        if (nextColumn == -1)
+            break;
 
         // Add normal note
         addToPattern(pattern, nextColumn);
@@ -383,11 +390,10 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomPatternWithMirror
     return pattern;
 }
 
-Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomPattern(double p2, double p3, double p4, double p5) const
+template<int KeyCount>
+Mania::Pattern Mania::HitObjectPatternGenerator<KeyCount>::generateRandomPattern(double p2, double p3, double p4, double p5) const
 {
-    Pattern pattern{ totalColumns };
-    
-    pattern += generateRandomNotes(getRandomNoteCount(p2, p3, p4, p5));
+    auto pattern = generateRandomNotes(getRandomNoteCount(p2, p3, p4, p5));
 
     if (randomStart > 0 && hasSpecialColumn())
         addToPattern(pattern, 0);
@@ -398,27 +404,141 @@ Mania::Pattern Mania::HitObjectPatternGenerator::generateRandomPattern(double p2
 Mania::ManiaBeatmapConverter::ManiaBeatmapConverter(OsuFile const& originalBeatmap) 
     : BeatmapConverter{ originalBeatmap }, 
     beatmap{ originalBeatmap },
-    targetColumns{ getTargetColumn() }
+    targetColumns{ GetTargetColumn(originalBeatmap.getPercentOf<HitObject::Type::Slider, HitObject::Type::Spinner>(), originalBeatmap.difficulty) },
+    generateForTarget{ GetGenerateConverted(targetColumns, true) },
+    seed{ GetDefaultSeed(originalBeatmap) },
+    state{ RandomEngine{ seed }, targetColumns }
+{
+
+}
+
+Mania::ManiaBeatmapConverter::ManiaBeatmapConverter(StreamPrescan const& prescan)
+    : BeatmapConverter{ prescan.header },
+    beatmap{ prescan.header },
+    targetColumns{ GetTargetColumn(prescan.getPercentSliderOrSpinner(), prescan.header.difficulty) },
+    generateForTarget{ GetGenerateConverted(targetColumns, true) },
+    seed{ prescan.seed },
+    state{ RandomEngine{ seed }, targetColumns },
+    context{ std::in_place, ConversionContext::GetConversionDifficulty(prescan.header.difficulty, prescan.objectCount, prescan.getDrainTime()) }
+{
+}
+
+std::uint64_t Mania::ManiaBeatmapConverter::GetDefaultSeed(OsuFile const& originalBeatmap)
 {
+    SeedHash hash;
+    for (auto const& object : originalBeatmap.hitObjects)
+        hash.add(object->time, object->x, object->y, object->type);
+    return hash.get();
+}
 
+void Mania::ManiaBeatmapConverter::SeedHash::add(int time, int x, int y, HitObject::Type type)
+{
+    combine(time);
+    combine(x);
+    combine(y);
+    combine(static_cast<std::int64_t>(type));
+}
+
+void Mania::ManiaBeatmapConverter::SeedHash::combine(std::int64_t value)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        hash ^= static_cast<std::uint8_t>(value >> (i * 8));
+        hash *= 0x100000001b3;
+    }
+}
+
+Mania::ManiaBeatmapConverter& Mania::ManiaBeatmapConverter::setSeed(std::uint64_t seed)
+{
+    this->seed = seed;
+    state.random = RandomEngine{ seed };
+    return *this;
+}
+
+Mania::ManiaBeatmapConverter& Mania::ManiaBeatmapConverter::setSegments(std::optional<SegmentOptions> options)
+{
+    segments = options;
+    return *this;
+}
+
+Mania::ManiaBeatmapConverter& Mania::ManiaBeatmapConverter::setCandidates(std::optional<CandidateOptions> options)
+{
+    if (options && options->count <= 0)
+        throw std::invalid_argument{ "Invalid candidate count" };
+    candidates = options;
+    return *this;
 }
 
 OsuFile Mania::ManiaBeatmapConverter::convertBeatmap()
 {
-    auto f = BeatmapConverter::convertBeatmap();
-    f.difficulty.circleSize = static_cast<float>(targetColumns);
+    return makeConverted(targetColumns, convertHitObjects());
+}
+
+std::vector<OsuFile> Mania::ManiaBeatmapConverter::convertBeatmaps(std::vector<int> const& keyCounts)
+{
+    struct Target
+    {
+        GenerateConverted generate;
+        ConversionState state;
+        std::vector<std::unique_ptr<HitObject>> notes;
+    };
+
+    /*Every key count starts from the same random engine, as if it was converted alone*/
+    std::vector<Target> targets;
+    targets.reserve(keyCounts.size());
+    for (auto const keyCount : keyCounts)
+    {
+        if (keyCount <= 0 || keyCount > MaxKeyCount)
+            throw std::invalid_argument{ "Invalid target columns" };
+        targets.push_back(Target{ GetGenerateConverted(keyCount, true), ConversionState{ RandomEngine{ seed }, keyCount }, {} });
+        targets.back().notes.reserve(originalBeatmap.hitObjects.size() * 2);
+    }
+
+    context.emplace(originalBeatmap);
+    NoteHistory history;
+    for (size_t i = 0; i < originalBeatmap.hitObjects.size(); ++i)
+    {
+        auto const& original = *originalBeatmap.hitObjects[i];
+        history.begin(original);
+        for (auto& target : targets)
+            (this->*target.generate)(original, context->objects[i], history, target.state, target.notes);
+        history.end(original, context->objects[i]);
+    }
+
+    std::vector<OsuFile> result;
+    result.reserve(targets.size());
+    for (auto& target : targets)
+    {
+        state.columnStats += target.state.columnStats;
+        result.push_back(makeConverted(target.state.keyCount, std::move(target.notes)));
+    }
+    return result;
+}
+
+OsuFile Mania::ManiaBeatmapConverter::makeConverted(int keyCount, std::vector<std::unique_ptr<HitObject>> hitObjects) const
+{
+    OsuFile f{
+        originalBeatmap.general,
+        originalBeatmap.editor,
+        originalBeatmap.metaData,
+        originalBeatmap.difficulty,
+        originalBeatmap.events,
+        originalBeatmap.timingPoints,
+        originalBeatmap.colors,
+        std::move(hitObjects)
+    };
+    f.difficulty.circleSize = static_cast<float>(keyCount);
     f.general.mode = Mode::Mania;
     return f;
 }
 
-int Mania::ManiaBeatmapConverter::getTargetColumn() const
+int Mania::ManiaBeatmapConverter::GetTargetColumn(float percentSliderOrSpinner, Difficulty const& difficulty)
 {
-    auto const percentSliderOrSpinner = originalBeatmap.getPercentOf<HitObject::Type::Slider, HitObject::Type::Spinner>();
-    auto const roundedDifficulty = std::round(originalBeatmap.difficulty.overallDifficulty);
+    auto const roundedDifficulty = std::round(difficulty.overallDifficulty);
 
     if (percentSliderOrSpinner < 0.2)
         return 7;
-    else if (percentSliderOrSpinner < 0.3 || std::round(originalBeatmap.difficulty.circleSize) >= 5)
+    else if (percentSliderOrSpinner < 0.3 || std::round(difficulty.circleSize) >= 5)
         return roundedDifficulty > 5 ? 7 : 6;
     else if (percentSliderOrSpinner > 0.6)
         return roundedDifficulty > 4 ? 5 : 4;
@@ -432,33 +552,34 @@ int Mania::ManiaBeatmapConverter::getTargetColumn() const
 //    for()
 //}
 
-Mania::ManiaBeatmapConverter& Mania::ManiaBeatmapConverter::setTargetColumn(int target)
+Mania::ManiaBeatmapConverter& Mania::ManiaBeatmapConverter::setTargetColumn(int target, bool specialized)
 {
-    if (target <= 0 || target > 9)
+    if (target <= 0 || target > MaxKeyCount)
         throw std::invalid_argument{ "Invalid target columns" };
     targetColumns = target;
+    state.keyCount = target;
+    generateForTarget = GetGenerateConverted(target, specialized);
     return *this;
 }
 
-void Mania::ManiaBeatmapConverter::handleNewPattern(Pattern pattern, Pattern::Type stairType, std::vector<std::unique_ptr<HitObject>>& result)
+void Mania::ManiaBeatmapConverter::handleNewPattern(HitObject const& original, Pattern const& pattern, Pattern::Type stairType, ConversionState& state, std::vector<std::unique_ptr<HitObject>>& result) const
 {
     /*update lastStair*/
-    lastStair = stairType;
+    state.lastStair = stairType;
     
     /*insert into result vector*/
-    result.reserve(result.size() + pattern.hitObjects.size());
-    std::transform(
-        pattern.hitObjects.cbegin(), 
-        pattern.hitObjects.cend(), 
-        std::back_inserter(result),
-        [](std::unique_ptr<HitObject> const& obj)
-        {
-            return obj->clone();
-        }
-    );
+    pattern.materialize(result, original);
+
+    /*update lastPattern, the next generator only needs the summary*/
+    state.lastPattern = pattern.summarize();
+}
 
-    /*update lastPattern*/
-    lastPattern.emplace(std::move(pattern));
+void Mania::ManiaBeatmapConverter::restart()
+{
+    auto const columnStats = state.columnStats;
+    history = NoteHistory{};
+    state = ConversionState{ RandomEngine{ seed }, targetColumns };
+    state.columnStats = columnStats;
 }
 
 OsuFile BeatmapConverter::convertBeatmap()
@@ -491,7 +612,198 @@ std::vector<std::unique_ptr<HitObject>> BeatmapConverter::convertHitObjects()
 
 std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::convertHitObject(HitObject const& original)
 {
-    return generateConverted(original);
+    if (!context)
+        context.emplace(originalBeatmap);
+
+    /*Empty for a converter made from a StreamPrescan*/
+    auto const index = static_cast<size_t>(state.objectIndex + 1);
+    if (index >= context->objects.size())
+        throw std::out_of_range{ "convertHitObject() past the last original hit object" };
+
+    std::vector<std::unique_ptr<HitObject>> result;
+    auto const& objectContext = context->objects[index];
+    history.begin(original);
+    (this->*generateForTarget)(original, objectContext, history, state, result);
+    history.end(original, objectContext);
+    return result;
+}
+
+std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::convertHitObjects()
+{
+    context.emplace(originalBeatmap);
+    restart();
+    if (candidates)
+        return convertCandidates(*candidates);
+    if (segments)
+        return convertSegments(*segments);
+
+    std::vector<std::unique_ptr<HitObject>> result;
+
+    /*Most objects become 1 or 2 notes*/
+    result.reserve(originalBeatmap.hitObjects.size() * 2);
+    convertRange(0, originalBeatmap.hitObjects.size(), history, state, result);
+    return result;
+}
+
+void Mania::ManiaBeatmapConverter::convertRange(size_t begin, size_t end, NoteHistory& history, ConversionState& state, std::vector<std::unique_ptr<HitObject>>& result)
+{
+    for (auto i = begin; i < end; ++i)
+    {
+        auto const& original = *originalBeatmap.hitObjects[i];
+        history.begin(original);
+        (this->*generateForTarget)(original, context->objects[i], history, state, result);
+        history.end(original, context->objects[i]);
+    }
+}
+
+/**
+ * @brief Call `task(i)` for every i in [0, count) on up to `threads` threads, 0 for one per hardware thread
+ * @details A fixed number of workers pulling from a shared index, the calling thread being one of them
+ */
+template<typename Task>
+static void ParallelFor(size_t count, unsigned threads, Task&& task)
+{
+    std::atomic<size_t> next{};
+    auto worker = [&]()
+    {
+        for (auto i = next++; i < count; i = next++)
+            task(i);
+    };
+
+    auto const threadCount = std::min<size_t>(threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency()), count);
+    std::vector<std::future<void>> workers;
+    for (size_t i = 1; i < threadCount; ++i)
+        workers.emplace_back(std::async(std::launch::async, worker));
+    worker();
+    for (auto& future : workers)
+        future.get();
+}
+
+std::vector<size_t> Mania::FindSegmentStarts(OsuFile const& originalBeatmap, ConversionContext const& context, double minGapInBeats)
+{
+    auto const& objects = originalBeatmap.hitObjects;
+    if (objects.empty())
+        return {};
+
+    std::vector<size_t> starts{ 0 };
+    auto const& breaks = originalBeatmap.events.breaks;
+    auto nextBreak = breaks.cbegin();
+    auto previousEnd = context.objects.front().endTime;
+    for (size_t i = 1; i < objects.size(); ++i)
+    {
+        auto const time = objects[i]->time;
+
+        /*A break starting after the previous object ended*/
+        auto breakBefore = false;
+        for (; nextBreak != breaks.cend() && nextBreak->startTime < time; ++nextBreak)
+            breakBefore |= nextBreak->startTime >= previousEnd;
+
+        if (breakBefore || time - previousEnd >= minGapInBeats * context.objects[i].beatLength)
+            starts.push_back(i);
+        previousEnd = std::max(previousEnd, context.objects[i].endTime);
+    }
+    return starts;
+}
+
+std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::convertSegments(SegmentOptions const& options)
+{
+    auto const& objects = originalBeatmap.hitObjects;
+    auto const starts = FindSegmentStarts(originalBeatmap, *context, options.minGapInBeats);
+
+    /*The streams are split in segment order, so they don't depend on which thread converts which segment*/
+    auto random = state.random;
+    std::vector<ConversionState> states;
+    states.reserve(starts.size());
+    for (auto const start : starts)
+    {
+        states.emplace_back(random.split(), targetColumns);
+        states.back().objectIndex = static_cast<int>(start) - 1;
+    }
+
+    std::vector<std::vector<std::unique_ptr<HitObject>>> converted(starts.size());
+    ParallelFor(starts.size(), options.threads, [&](size_t i)
+    {
+        auto const end = i + 1 < starts.size() ? starts[i + 1] : objects.size();
+        converted[i].reserve((end - starts[i]) * 2);
+
+        NoteHistory history;
+        convertRange(starts[i], end, history, states[i], converted[i]);
+    });
+
+    /*Stitch the segments in order*/
+    size_t noteCount{};
+    for (auto const& notes : converted)
+        noteCount += notes.size();
+
+    std::vector<std::unique_ptr<HitObject>> result;
+    result.reserve(noteCount);
+    for (size_t i = 0; i < converted.size(); ++i)
+    {
+        std::move(converted[i].begin(), converted[i].end(), std::back_inserter(result));
+        state.columnStats += states[i].columnStats;
+    }
+    return result;
+}
+
+std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::convertCandidates(CandidateOptions const& options)
+{
+    auto const& objects = originalBeatmap.hitObjects;
+
+    /*The streams are split in candidate order, so they don't depend on which thread converts which candidate*/
+    auto random = state.random;
+    std::vector<RandomEngine> streams;
+    streams.reserve(options.count);
+    for (int i = 0; i < options.count; ++i)
+        streams.push_back(random.split());
+
+    std::mutex bestMutex;
+    std::vector<std::unique_ptr<HitObject>> best;
+    ColumnSelectionStats bestStats;
+    bestCandidate.reset();
+
+    ParallelFor(options.count, options.threads, [&](size_t i)
+    {
+        NoteHistory history;
+        ConversionState candidate{ streams[i], targetColumns };
+        std::vector<std::unique_ptr<HitObject>> notes;
+        notes.reserve(objects.size() * 2);
+        convertRange(0, objects.size(), history, candidate, notes);
+
+        CandidateScore const score{ static_cast<int>(i), GetConversionPenalty(Analyze::AnalyzeMania(Analyze::SplitColumns(notes, targetColumns))) };
+
+        /*The loser is freed when `notes` goes out of scope, after the lock is released*/
+        std::lock_guard lock{ bestMutex };
+        if (!bestCandidate || score.penalty < bestCandidate->penalty || (score.penalty == bestCandidate->penalty && score.index < bestCandidate->index))
+        {
+            std::swap(best, notes);
+            bestStats = candidate.columnStats;
+            bestCandidate = score;
+        }
+    });
+
+    state.columnStats += bestStats;
+    return best;
+}
+
+double Mania::GetConversionPenalty(Analyze::ManiaAnalysis const& analysis)
+{
+    if (analysis.noteCount == 0 || analysis.keyCount == 0)
+        return 0;
+
+    auto const mean = static_cast<double>(analysis.noteCount) / analysis.keyCount;
+    double variance{};
+    for (auto const count : analysis.columnCounts)
+        variance += (count - mean) * (count - mean);
+    auto const imbalance = std::sqrt(variance / analysis.keyCount) / mean;
+
+    auto const jacks = std::accumulate(analysis.jackCounts.cbegin(), analysis.jackCounts.cend(), 0);
+
+    auto const spikeSize = std::max(3, analysis.keyCount / 2 + 1);
+    auto const spikes = spikeSize < static_cast<int>(analysis.chordSizes.size())
+        ? std::accumulate(analysis.chordSizes.cbegin() + spikeSize, analysis.chordSizes.cend(), 0)
+        : 0;
+
+    return imbalance + static_cast<double>(jacks + spikes) / analysis.noteCount;
 }
 
 //OsuFile Mania::ManiaBeatmapConverter::convertBeatmap()
@@ -500,29 +812,52 @@ std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::convertHit
 //}
 
 
-void Mania::ManiaBeatmapConverter::recordNote(HitObject const& note)
+void Mania::ManiaBeatmapConverter::NoteHistory::begin(HitObject const& original)
+{
+    if (original.type == HitObject::Type::Circle)
+        computeDensity(original.time);
+}
+
+void Mania::ManiaBeatmapConverter::NoteHistory::end(HitObject const& original, HitObjectContext const& context)
 {
-    recordNote(note.time, Coord{ note.x, note.y });
+    switch (original.type)
+    {
+        case HitObject::Type::Circle:
+            recordNote(original.time, Coord{ original.x, original.y });
+            break;
+        case HitObject::Type::Slider:
+        {
+            /*Every slide end counts as a note*/
+            auto const spanCount = static_cast<Slider const&>(original).slides;
+            for (int i = 0; i <= spanCount; ++i)
+            {
+                auto const time = original.time + context.segmentDuration * i;
+                recordNote(time, Coord{ original.x, original.y });
+                computeDensity(time);
+            }
+            break;
+        }
+        default:
+            break;
+    }
 }
 
-void Mania::ManiaBeatmapConverter::recordNote(int time, Coord position)
+void Mania::ManiaBeatmapConverter::NoteHistory::recordNote(int time, Coord position)
 {
     lastTime = time;
     lastPosition = position;
 }
 
-void Mania::ManiaBeatmapConverter::computeDensity(int newNoteTime)
+void Mania::ManiaBeatmapConverter::NoteHistory::computeDensity(int newNoteTime)
 {
-    if (prevNoteTimes.size() == MaxNotesForDensity)
-        prevNoteTimes.erase(prevNoteTimes.begin());
-    
-    prevNoteTimes.push_back(newNoteTime);
+    prevNoteTimes.push(newNoteTime);
 
     if (prevNoteTimes.size() >= 2)
-        density = (prevNoteTimes.back() - prevNoteTimes.front()) / static_cast<double>(prevNoteTimes.size());
+        density = prevNoteTimes.getDensity();
 }
 
-std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::generateConverted(HitObject const& original)
+template<int KeyCount>
+void Mania::ManiaBeatmapConverter::generateConverted(HitObject const& original, HitObjectContext const& objectContext, NoteHistory const& history, ConversionState& state, std::vector<std::unique_ptr<HitObject>>& result)
 {
     /*
     * In osu lazer, it's 
@@ -534,44 +869,43 @@ std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::generateCo
     * }
     */
 
-    std::vector<std::unique_ptr<HitObject>> result;
+    ++state.objectIndex;
     switch (original.type)
     {
         case HitObject::Type::Circle:   //IHasPosition
         {
-            computeDensity(original.time);
-            HitObjectPatternGenerator conversion{ 
+            HitObjectPatternGenerator<KeyCount> conversion{ 
                 original, 
                 beatmap, 
-                lastPattern.has_value()? std::move(*lastPattern) : Pattern{targetColumns}, 
-                lastTime, 
-                lastPosition, 
-                density, 
-                lastStair, 
-                originalBeatmap,
-                targetColumns
+                state.lastPattern.value_or(PatternSummary{ state.keyCount }), 
+                history.lastTime, 
+                history.lastPosition, 
+                history.density, 
+                state.lastStair, 
+                *context,
+                state.objectIndex,
+                objectContext,
+                state.keyCount,
+                state.random
             };
-            recordNote(original.time, Coord{ original.x, original.y });
-            handleNewPattern(conversion.generate(), conversion.stairType, result);
+            handleNewPattern(original, conversion.generate(), conversion.stairType, state, result);
+            state.columnStats += conversion.getColumnStats();
             break;
         }
         case HitObject::Type::Slider:   //IHasDistance
         {
-            DistanceObjectPatternGenerator conversion{
+            DistanceObjectPatternGenerator<KeyCount> conversion{
                 original,
                 beatmap,
-                lastPattern.has_value()? std::move(*lastPattern) : Pattern{targetColumns},
-                originalBeatmap,
-                targetColumns
+                state.lastPattern.value_or(PatternSummary{ state.keyCount }),
+                *context,
+                state.objectIndex,
+                objectContext,
+                state.keyCount,
+                state.random
             };
-
-            for (int i = 0; i <= conversion.spanCount; ++i)
-            {
-                auto const time = original.time + conversion.segmentDuration * i;
-                recordNote(time, { original.x, original.y });
-                computeDensity(time);
-            }
-            handleNewPattern(conversion.generate(), conversion.convertType, result);
+            handleNewPattern(original, conversion.generate(), conversion.convertType, state, result);
+            state.columnStats += conversion.getColumnStats();
             break;
         }
         case HitObject::Type::Spinner:  //IHasEndTime
@@ -580,11 +914,20 @@ std::vector<std::unique_ptr<HitObject>> Mania::ManiaBeatmapConverter::generateCo
         default:
             break;
     }
+}
 
-    return result;
+Mania::ManiaBeatmapConverter::GenerateConverted Mania::ManiaBeatmapConverter::GetGenerateConverted(int keyCount, bool specialized)
+{
+    /*Indexed by key count, `DynamicKeyCount` is 0*/
+    constexpr static auto generateConverted = MakeGenerateConverted(std::make_integer_sequence<int, MaxKeyCount + 1>{});
+    static_assert(DynamicKeyCount == 0);
+
+    assert(keyCount > 0 && keyCount <= MaxKeyCount);
+    return specialized ? generateConverted[keyCount] : generateConverted[DynamicKeyCount];
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generate()
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generate()
 {
     assert(startTime == hitObject.time);
 #ifdef PrintDetail
@@ -669,18 +1012,20 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generate()
     return generateNRandomNotes(startTime, 0.27, 0, 0);
 }
 
-Mania::DistanceObjectPatternGenerator::DistanceObjectPatternGenerator(HitObject const& hitObject, OsuFile& beatmap, Pattern&& previousPattern, OsuFile const& originalBeatmap, int totalColumns)
-    : PatternGenerator(std::move(previousPattern), hitObject, originalBeatmap, totalColumns),
+template<int KeyCount>
+Mania::DistanceObjectPatternGenerator<KeyCount>::DistanceObjectPatternGenerator(HitObject const& hitObject, OsuFile& beatmap, PatternSummary const& previousPattern, ConversionContext const& context, int hitObjectIndex, HitObjectContext const& objectContext, int totalColumns, RandomEngine& random)
+    : Base(previousPattern, hitObject, context, hitObjectIndex, objectContext, totalColumns, random),
     startTime{hitObject.time},
-    spanCount{ dynamic_cast<Slider const&>(hitObject).slides},
-    endTime{ static_cast<int>(getEndTime())},
-    segmentDuration{ static_cast<int>(getSegmentDuration())},
+    spanCount{ static_cast<Slider const&>(hitObject).slides},
+    endTime{ objectContext.endTime },
+    segmentDuration{ objectContext.segmentDuration },
     convertType{ Pattern::Type::LowProbability }
 {
-    //assert(segmentDuration >= originalBeatmap.timingPoints.front().beatLength / 32);
+    assert(segmentDuration >= 0);
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomHoldNotes(int startTime, int noteCount)
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateRandomHoldNotes(int startTime, int noteCount)
 {
     Pattern pattern{ totalColumns };
 
@@ -690,7 +1035,9 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomHoldNotes(in
     for (int i = 0; i < std::min(usableColumns, noteCount); ++i)
     {
         // Find available column
-        nextColumn = findAvailableColumn(nextColumn, { &pattern, &previousPattern });
+        nextColumn = findAvailableColumn(nextColumn, { pattern.columnMask, previousPattern.columnMask });
+        if (nextColumn == -1)
+            break;
         //pattern += std::make_unique<Hold>(HitObject::ColumnToX(nextColumn, totalColumns), 192, startTime, HitObject::HitSound{}, endTime, HitObject::HitSample{});
         addToPattern(pattern, nextColumn, startTime, endTime);
     }
@@ -698,7 +1045,9 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomHoldNotes(in
     // This is can't be combined with the above loop due to RNG
     for (int i = 0; i < noteCount - usableColumns; i++)
     {
-        nextColumn = findAvailableColumn(nextColumn, { &pattern });
+        nextColumn = findAvailableColumn(nextColumn, { pattern.columnMask });
+        if (nextColumn == -1)
+            break;
         //pattern += std::make_unique<Hold>(HitObject::ColumnToX(nextColumn, totalColumns), 192, startTime, HitObject::HitSound{}, endTime, HitObject::HitSample{});
         addToPattern(pattern, nextColumn, startTime, endTime);
     }
@@ -706,21 +1055,24 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomHoldNotes(in
     return pattern;
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomNotes(int startTime, int noteCount) 
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateRandomNotes(int startTime, int noteCount) 
 {
     Pattern pattern{ totalColumns };
 
     int nextColumn = hitObject.getColumnIndex(totalColumns);
 
     if ((convertType & Pattern::Type::ForceNotStack) && previousPattern.numColumnWithObject() < totalColumns)
-        nextColumn = findAvailableColumn(nextColumn, { &previousPattern });
+        nextColumn = findAvailableColumn(nextColumn, { previousPattern.columnMask });
 
     int lastColumn = nextColumn;
 
     for (int i = 0; i < noteCount; i++)
     {
         //pattern += std::make_unique<Hold>(HitObject::ColumnToX(nextColumn, totalColumns), 192, startTime, HitObject::HitSound{}, endTime, HitObject::HitSample{});
-        addToPattern(pattern, nextColumn, startTime, endTime);
+        /*Skipped if no column was found*/
+        if (nextColumn != -1)
+            addToPattern(pattern, nextColumn, startTime, endTime);
         nextColumn = findAvailableColumn(nextColumn, {}, {}, {}, [lastColumn](int c) { return c != lastColumn; }, {});
         lastColumn = nextColumn;
         startTime += segmentDuration;
@@ -729,7 +1081,8 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomNotes(int st
     return pattern;
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateStair(int startTime) 
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateStair(int startTime) 
 {
     // - - - -
     // x - - -
@@ -743,7 +1096,7 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateStair(int startTim
     Pattern pattern{ totalColumns };
 
     int column = hitObject.getColumnIndex(totalColumns);
-    bool increasing = RandomEngine::getRand() > 0.5;
+    bool increasing = random.getRand() > 0.5;
 
     for (int i = 0; i <= spanCount; i++)
     {
@@ -777,7 +1130,8 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateStair(int startTim
     return pattern;
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomMultipleNotes(int startTime) 
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateRandomMultipleNotes(int startTime) 
 {
     // - - - -
     // x - - -
@@ -788,7 +1142,7 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomMultipleNote
     Pattern pattern{ totalColumns };
 
     bool legacy = totalColumns >= 4 && totalColumns <= 8;
-    int interval = RandomEngine::getRand(Range{ 1, totalColumns - (legacy ? 1 : 0) });
+    int interval = random.getRand(Range{ 1, totalColumns - (legacy ? 1 : 0) });
 
     int nextColumn = hitObject.getColumnIndex(totalColumns);
 
@@ -814,7 +1168,8 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateRandomMultipleNote
     return pattern;
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateNRandomNotes(int startTime, double p2, double p3, double p4) 
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateNRandomNotes(int startTime, double p2, double p3, double p4) 
 {
     // - - - -
     // �� - �� ��
@@ -856,10 +1211,11 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateNRandomNotes(int s
     if (canGenerateTwoNotes)
         p2 = 1;
 
-    return generateRandomHoldNotes(startTime, GetRandomNoteCount(p2, p3, p4));
+    return generateRandomHoldNotes(startTime, GetRandomNoteCount(random, p2, p3, p4));
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateTiledHoldNotes(int startTime) 
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateTiledHoldNotes(int startTime) 
 {
     // - - - -
     // �� �� �� ��
@@ -879,11 +1235,13 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateTiledHoldNotes(int
 
     int nextColumn = hitObject.getColumnIndex(totalColumns);
     if (convertType & (Pattern::Type::ForceNotStack) && previousPattern.numColumnWithObject() < totalColumns)
-        nextColumn = findAvailableColumn(nextColumn, { &previousPattern });
+        nextColumn = findAvailableColumn(nextColumn, { previousPattern.columnMask });
 
     for (int i = 0; i < columnRepeat; i++)
     {
-        nextColumn = findAvailableColumn(nextColumn, { &pattern });
+        nextColumn = findAvailableColumn(nextColumn, { pattern.columnMask });
+        if (nextColumn == -1)
+            break;
         //pattern += std::make_unique<Hold>(HitObject::ColumnToX(nextColumn, totalColumns), 192, startTime, HitObject::HitSound{}, endTime, HitObject::HitSample{});
         addToPattern(pattern, nextColumn, startTime, endTime);
         startTime += segmentDuration;
@@ -892,7 +1250,8 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateTiledHoldNotes(int
     return pattern;
 }
 
-Mania::Pattern Mania::DistanceObjectPatternGenerator::generateHoldAndNormalNotes(int startTime) 
+template<int KeyCount>
+Mania::Pattern Mania::DistanceObjectPatternGenerator<KeyCount>::generateHoldAndNormalNotes(int startTime) 
 {
     // - - - -
     // �� x x -
@@ -904,11 +1263,12 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateHoldAndNormalNotes
 
     int holdColumn = hitObject.getColumnIndex(totalColumns);
     if (convertType & (Pattern::Type::ForceNotStack) && previousPattern.numColumnWithObject() < totalColumns)
-        holdColumn = findAvailableColumn(holdColumn, { &previousPattern });
+        holdColumn = findAvailableColumn(holdColumn, { previousPattern.columnMask });
 
     // Create the hold note
     //pattern += std::make_unique<Hold>(HitObject::ColumnToX(holdColumn, totalColumns), 192, startTime, HitObject::HitSound{}, endTime, HitObject::HitSample{});
-    addToPattern(pattern, holdColumn, startTime, endTime);
+    if (holdColumn != -1)
+        addToPattern(pattern, holdColumn, startTime, endTime);
 
     int nextColumn = getRandomColumn();
     int noteCount;
@@ -916,11 +1276,11 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateHoldAndNormalNotes
     auto const conversionDifficulty = getConversionDifficulty();
 
     if (getConversionDifficulty() > 6.5)
-        noteCount = GetRandomNoteCount(0.63, 0);
+        noteCount = GetRandomNoteCount(random, 0.63, 0);
     else if (conversionDifficulty > 4)
-        noteCount = GetRandomNoteCount(totalColumns < 6 ? 0.12 : 0.45, 0);
+        noteCount = GetRandomNoteCount(random, totalColumns < 6 ? 0.12 : 0.45, 0);
     else if (conversionDifficulty > 2.5)
-        noteCount = GetRandomNoteCount(totalColumns < 6 ? 0 : 0.24, 0);
+        noteCount = GetRandomNoteCount(random, totalColumns < 6 ? 0 : 0.24, 0);
     else
         noteCount = 0;
     noteCount = std::min(totalColumns - 1, noteCount);
@@ -940,7 +1300,9 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateHoldAndNormalNotes
         {
             for (int j = 0; j < noteCount; j++)
             {
-                nextColumn = findAvailableColumn(nextColumn, {}, {}, {}, [holdColumn](int c) { return c != holdColumn; }, { &rowPattern });
+                nextColumn = findAvailableColumn(nextColumn, {}, {}, {}, [holdColumn](int c) { return c != holdColumn; }, { rowPattern.columnMask });
+                if (nextColumn == -1)
+                    break;
                 //rowPattern += std::make_unique<Circle>(HitObject::ColumnToX(nextColumn, totalColumns), 192, startTime, HitObject::HitSound{}, HitObject::HitSample{});
                 addToPattern(rowPattern, nextColumn, startTime);
             }
@@ -954,49 +1316,33 @@ Mania::Pattern Mania::DistanceObjectPatternGenerator::generateHoldAndNormalNotes
     return pattern;
 }
 
-double Mania::DistanceObjectPatternGenerator::getEndTime() const
-{
-    auto const& slider = dynamic_cast<Slider const&>(hitObject);
-
-    auto const beatLength = originalBeatmap.timingPoints.front().beatLength;
-    auto const bpmMultiplier = beatLength < 0 ? std::clamp(-beatLength, 10.f, 10000.f) / 100.0 : 1;
-    return std::floor(startTime + static_cast<double>(slider.length) * beatLength * spanCount * 0.01 / originalBeatmap.difficulty.sliderMultiplier);
-                                                        //160 / 
-}
-
-double Mania::DistanceObjectPatternGenerator::getSegmentDuration() const
-{
-    assert(endTime != 0);
-    return (endTime - startTime) / spanCount;
-}
-
-void Mania::DistanceObjectPatternGenerator::addToPattern(
+template<int KeyCount>
+void Mania::DistanceObjectPatternGenerator<KeyCount>::addToPattern(
     Pattern& pattern,
     int columnIndex,
     int startTime,
-    HitObject::HitSound hitSound,
-    HitObject::HitSample hitSample)
+    HitObject::HitSound hitSound)
 {
-    pattern += std::make_unique<Circle>(HitObject::ColumnToX(columnIndex, totalColumns), 192, startTime, hitSound, std::move(hitSample));
+    pattern += ManiaNote{ columnIndex, startTime, startTime, hitSound };
 }
 
-void Mania::DistanceObjectPatternGenerator::addToPattern(
+template<int KeyCount>
+void Mania::DistanceObjectPatternGenerator<KeyCount>::addToPattern(
     Pattern& pattern,
     int columnIndex,
     int startTime,
     int endTime,
-    HitObject::HitSound hitSound,
-    HitObject::HitSample hitSample)
+    HitObject::HitSound hitSound)
 {
     /*
         prevent hold note being too short
         This is usually caused by the conversion error between float/double <-> int
     */
     //assert(endTime > startTime);
-    if (endTime - startTime <= originalBeatmap.timingPoints.front().beatLength / 32)
-        addToPattern(pattern, columnIndex, startTime, hitSound, std::move(hitSample));
+    if (endTime - startTime <= objectContext.beatLength / 32)
+        addToPattern(pattern, columnIndex, startTime, hitSound);
     else
-        pattern += std::make_unique<Hold>(HitObject::ColumnToX(columnIndex, totalColumns), 192, startTime, hitSound, endTime, std::move(hitSample));
+        pattern += ManiaNote{ columnIndex, startTime, endTime, hitSound };
 }
 
 #include <future>
@@ -1013,79 +1359,138 @@ inline std::string toLowerInplace(std::string&& str)
     return str;
 }
 
-static inline bool ShouldConvert(std::filesystem::directory_entry const& entry)
+bool Mania::ShouldConvert(std::filesystem::directory_entry const& entry)
 {
     return entry.path().extension() == ".osu" && toLowerInplace(entry.path().filename().string()).find("convert") == std::string::npos;
 }
 
-std::future<void> Mania::ConvertImpl(std::filesystem::directory_entry const& entry)
+OsuFile Mania::ConvertForSave(OsuFile const& original, std::optional<std::uint64_t> seed, int keyCount)
+{
+    Mania::ManiaBeatmapConverter converter{ original };
+    converter.setTargetColumn(keyCount);
+    if (seed)
+        converter.setSeed(*seed);
+
+    auto convertedMap = converter.convertBeatmap();
+    if (keyCount != 4)
+        convertedMap.metaData.version += std::to_string(keyCount) + 'K';
+    convertedMap.metaData.version += "Converted";
+
+    if (Logger::Get().isEnabled(LogLevel::Info))
+    {
+        Log(LogLevel::Info, "\nGenerate:\n\t",
+            convertedMap.getCount<HitObject::Type::Circle>(), " circles\n",
+            '\t', convertedMap.getCount<HitObject::Type::Hold>(), " holds \n",
+            '\t', Analyze::ClassifySnaps(convertedMap).unsnapped.size(), " unsnapped\n",
+            '\t', converter.getColumnStats(), '\n',
+            '\t', Analyze::AnalyzeMania(convertedMap));
+    }
+
+    Mania::AddBreaks(convertedMap);
+    Mania::RemoveShortHolds(convertedMap);
+    convertedMap.metaData.version += "Break";
+
+    if (auto const lint = Analyze::Lint(convertedMap); !lint.empty())
+        Log(LogLevel::Info, "Lint: ", lint.issues.size(), " issues\n\t", lint);
+    return convertedMap;
+}
+
+std::filesystem::path Mania::SaveConverted(OsuFile& convertedMap, std::filesystem::path const& directory)
+{
+    auto fileName = convertedMap.getSaveFileName();
+    auto rootDir = directory.string();
+
+    constexpr auto IsRootCurrent = [](std::string const& dir)
+    {
+        return dir.empty() || dir == ".";
+    };
+
+    /*A map saved before may be hard linked to a cached map, which must not be truncated with it*/
+    auto const save = [&convertedMap](std::string const& path)
+    {
+        std::error_code error;
+        std::filesystem::remove(path + ".osu", error);
+        convertedMap.save(path.c_str());
+    };
+
+    #ifdef WIN32
+        auto path = IsRootCurrent(rootDir)? fileName : rootDir + "\\" + fileName;
+    #else
+        auto path = IsRootCurrent(rootDir)? fileName : rootDir + "/" + fileName;
+    #endif
+    try 
+    {
+        save(path);
+        return path + ".osu";
+    }
+    catch (std::exception const& e)
+    {
+        Log(LogLevel::Warning, e.what(), " Retrying!");
+        
+        /*Maybe because of file too long, make shorter then retry*/
+        convertedMap.metaData.version = "test";
+        fileName = convertedMap.getSaveFileName();
+
+        #ifdef WIN32
+            path = IsRootCurrent(rootDir) ? fileName : rootDir + "\\" + fileName;
+        #else
+            path = IsRootCurrent(rootDir) ? fileName : rootDir + "/" + fileName;
+        #endif
+        try 
+        {
+            save(path);
+            return path + ".osu";
+        }
+        catch(std::exception const& e)
+        {
+            Log(LogLevel::Error, e.what());
+        }
+    }
+    return {};
+}
+
+std::filesystem::path Mania::ConvertAndSave(std::string content, std::filesystem::path const& source, std::optional<std::uint64_t> seed, ConversionCache* cache, int keyCount)
+{
+    std::uint64_t key{};
+    if (cache)
+    {
+        key = ConversionCache::GetKey(content, GetSaveParameters(seed, keyCount));
+        if (auto cached = cache->fetch(key, source.parent_path()); !cached.empty())
+        {
+            Log(LogLevel::Info, "Cached ", source, " -> ", cached);
+            return cached;
+        }
+    }
+
+    Log(LogLevel::Info, "Converting ", source);
+    std::istringstream stream{ std::move(content) };
+    auto convertedMap = ConvertForSave(OsuFile{ stream }, seed, keyCount);
+    auto converted = SaveConverted(convertedMap, source.parent_path());
+    if (converted.empty())
+        throw std::runtime_error{ "File not writable!" };
+
+    if (cache)
+        cache->store(key, converted);
+    return converted;
+}
+
+std::future<void> Mania::ConvertImpl(ThreadPool& pool, std::filesystem::directory_entry const& entry, std::optional<std::uint64_t> seed, ConversionCache* cache, MemoryBudget* budget)
 {
     return
-        std::async(
-            std::launch::async,
-            [entry]()
+        pool.submit(
+            [entry, seed, cache, budget]()
             {
-                std::cout << "Converting " << entry << '\n';
-                OsuFile f{ std::ifstream{entry.path()} };
-                Mania::ManiaBeatmapConverter converter{ f };
-                converter.setTargetColumn(4);
-
-                auto convertedMap = converter.convertBeatmap();
-                convertedMap.metaData.version += "Converted";
-
-                {
-                    std::cout << "\nGenerate:\n\t"
-                        << convertedMap.getCount<HitObject::Type::Circle>() << " circles\n"
-                        << '\t' << convertedMap.getCount<HitObject::Type::Hold>() << " holds \n"
-                        << '\t';
-                    for (int i = 0; i < convertedMap.difficulty.circleSize; ++i)
-                        std::cout << convertedMap.getPercentOfHitObjectInColumn(i) * 100.f << "%   ";
-                }
-
-                Mania::AddBreaks(convertedMap);
-                Mania::RemoveShortHolds(convertedMap);
-                convertedMap.metaData.version += "Break";
-
-                auto fileName = convertedMap.getSaveFileName();
-                auto rootDir = entry.path().parent_path().string();
-
-                constexpr auto IsRootCurrent = [](std::string const& dir)
-                {
-                    return dir.empty() || dir == ".";
-                };
-
-                #ifdef WIN32
-                    auto path = IsRootCurrent(rootDir)? fileName : rootDir + "\\" + fileName;
-                #else
-                    auto path = IsRootCurrent(rootDir)? fileName : rootDir + "/" + fileName;
-                #endif
-                try 
-                {
-                    convertedMap.save(path.c_str());
-                }
-                catch (std::exception const& e)
-                {
-                    std::cerr << e.what() <<" Retrying!"<< '\n';
-                    
-                    /*Maybe because of file too long, make shorter then retry*/
-                    convertedMap.metaData.version = "test";
-                    fileName = convertedMap.getSaveFileName();
-
-                    #ifdef WIN32
-                        path = IsRootCurrent(rootDir) ? fileName : rootDir + "\\" + fileName;
-                    #else
-                        path = IsRootCurrent(rootDir) ? fileName : rootDir + "/" + fileName;
-                    #endif
-                    try 
-                    {
-                        convertedMap.save(path.c_str());
-                    }
-                    catch(std::exception const& e)
-                    {
-                        std::cerr << e.what() << '\n';
-                    }
-                }
+                /*Admitted before the text is read, and held until the converted map is saved and freed*/
+                std::error_code error;
+                auto reservation = budget ? budget->admit(EstimateConversionMemoryBound(entry.file_size(error))) : MemoryBudget::Reservation{};
+
+                std::ifstream file{ entry.path(), std::ios::binary };
+                if (!file.is_open())
+                    throw std::runtime_error{ "File not readable!" };
+                std::string content{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
 
+                reservation.shrink(EstimateConversionMemory(content));
+                (void)ConvertAndSave(std::move(content), entry.path(), seed, cache);
             }
         );
     
@@ -1093,33 +1498,96 @@ std::future<void> Mania::ConvertImpl(std::filesystem::directory_entry const& ent
 
 #include <type_traits>
 template<typename DirectoryIterator>
-void ConvertAllImpl(DirectoryIterator&& dir)
+void ConvertAllImpl(DirectoryIterator&& dir, std::optional<std::uint64_t> seed, unsigned threads)
 {
-    std::vector<std::future<void>> futures;
+    std::vector<std::filesystem::directory_entry> entries;
     for (auto&& entry : dir)
     {
         /*Do not convert maps that's already converted*/
-        if (ShouldConvert(entry))
-            futures.emplace_back(Mania::ConvertImpl(entry));
+        if (Mania::ShouldConvert(entry))
+            entries.push_back(entry);
     }
+    Mania::ConvertFiles(std::move(entries), seed, threads);
+}
 
-    for (auto& future : futures)
-        future.get();
+void Mania::SortLargestFirst(std::vector<std::filesystem::directory_entry>& entries)
+{
+    std::vector<std::pair<std::uintmax_t, std::filesystem::directory_entry>> sized;
+    sized.reserve(entries.size());
+    for (auto& entry : entries)
+    {
+        std::error_code error;
+        auto const size = entry.file_size(error);
+        sized.emplace_back(error ? 0 : size, std::move(entry));
+    }
+    std::stable_sort(sized.begin(), sized.end(), [](auto const& lhs, auto const& rhs) { return lhs.first > rhs.first; });
+
+    for (size_t i = 0; i < sized.size(); ++i)
+        entries[i] = std::move(sized[i].second);
 }
 
-void Mania::ConvertAll(std::filesystem::recursive_directory_iterator dir)
+/**
+ * @brief Wait for every conversion, reporting the ones that failed
+ */
+static void WaitConversions(std::vector<std::filesystem::directory_entry> const& entries, std::vector<std::future<void>>& futures)
 {
-    ConvertAllImpl(dir);
+    for (size_t i = 0; i < futures.size(); ++i)
+    {
+        try
+        {
+            futures[i].get();
+        }
+        catch (std::exception const& e)
+        {
+            Log(LogLevel::Error, "Cannot convert ", entries[i].path().string(), ": ", e.what());
+        }
+    }
 }
 
-void Mania::ConvertAll(std::filesystem::directory_iterator dir)
+void Mania::ConvertFiles(std::vector<std::filesystem::directory_entry> entries, std::optional<std::uint64_t> seed, unsigned threads, ConversionCache* cache, MemoryBudget* budget)
 {
-    ConvertAllImpl(dir);
+    /*Longest processing time first, the file size standing for the conversion time*/
+    SortLargestFirst(entries);
+
+    ThreadPool pool{ threads };
+    std::vector<std::future<void>> futures;
+    futures.reserve(entries.size());
+    for (auto const& entry : entries)
+        futures.push_back(ConvertImpl(pool, entry, seed, cache, budget));
+
+    WaitConversions(entries, futures);
+}
+
+void Mania::ConvertAll(std::filesystem::recursive_directory_iterator dir, std::optional<std::uint64_t> seed, unsigned threads)
+{
+    ConvertAllImpl(dir, seed, threads);
 }
 
-void Mania::ConvertAll(std::filesystem::path path)
+void Mania::ConvertAll(std::filesystem::directory_iterator dir, std::optional<std::uint64_t> seed, unsigned threads)
 {
-    ConvertAll(std::filesystem::recursive_directory_iterator{ std::move(path) });
+    ConvertAllImpl(dir, seed, threads);
+}
+
+void Mania::ConvertAll(std::filesystem::path path, std::optional<std::uint64_t> seed, unsigned threads, ConversionCache* cache, MemoryBudget* budget)
+{
+    ThreadPool pool{ threads };
+    std::mutex mutex;
+    std::vector<std::filesystem::directory_entry> entries;
+    std::vector<std::future<void>> futures;
+
+    /*Each map is queued as soon as it is found, so the first conversion doesn't wait for the whole walk*/
+    DirectoryWalker{}.walk(path, [&](std::filesystem::directory_entry const& entry)
+    {
+        if (!ShouldConvert(entry))
+            return;
+
+        auto future = ConvertImpl(pool, entry, seed, cache, budget);
+        std::lock_guard lock{ mutex };
+        entries.push_back(entry);
+        futures.push_back(std::move(future));
+    });
+
+    WaitConversions(entries, futures);
 }
 
 /**
@@ -1172,7 +1640,7 @@ static auto MakeBreak(OsuFile& beatmap, Iter start, Iter end)
     auto const startTime = (*start)->time;
     auto const endTime = (*end)->time;
     /*Remove the hit objects*/
-    std::cerr << "Removed [" << startTime << " , " << endTime << "] hitobjects = " << beatmap.getNumHitObjectDuring(startTime, endTime) <<'\n';
+    Log(LogLevel::Debug, "Removed [", startTime, " , ", endTime, "] hitobjects = ", beatmap.getNumHitObjectDuring(startTime, endTime));
     beatmap.hitObjects.erase(start, end);
     
 
@@ -1222,7 +1690,7 @@ void Mania::AddBreaks(OsuFile& beatmap, int windowSizeInBeats, int hitObjectCoun
 
 static inline bool isOneFourthHold(Hold* hold, int beatLength)
 {
-    return abs(hold->getDuration() - beatLength / 4) <= beatLength / 16;
+    return abs(hold->getDuration() - beatLength / Mania::ShortHoldDivisor) <= beatLength / 16;
 }
 
 void Mania::RemoveShortHolds(OsuFile& beatmap)
@@ -1240,4 +1708,27 @@ void Mania::RemoveShortHolds(OsuFile& beatmap)
             }
         }
     }
-}
\ No newline at end of file
+}
+
+template class Mania::HitObjectPatternGenerator<Mania::DynamicKeyCount>;
+template class Mania::HitObjectPatternGenerator<1>;
+template class Mania::HitObjectPatternGenerator<2>;
+template class Mania::HitObjectPatternGenerator<3>;
+template class Mania::HitObjectPatternGenerator<4>;
+template class Mania::HitObjectPatternGenerator<5>;
+template class Mania::HitObjectPatternGenerator<6>;
+template class Mania::HitObjectPatternGenerator<7>;
+template class Mania::HitObjectPatternGenerator<8>;
+template class Mania::HitObjectPatternGenerator<9>;
+template class Mania::HitObjectPatternGenerator<10>;
+template class Mania::DistanceObjectPatternGenerator<Mania::DynamicKeyCount>;
+template class Mania::DistanceObjectPatternGenerator<1>;
+template class Mania::DistanceObjectPatternGenerator<2>;
+template class Mania::DistanceObjectPatternGenerator<3>;
+template class Mania::DistanceObjectPatternGenerator<4>;
+template class Mania::DistanceObjectPatternGenerator<5>;
+template class Mania::DistanceObjectPatternGenerator<6>;
+template class Mania::DistanceObjectPatternGenerator<7>;
+template class Mania::DistanceObjectPatternGenerator<8>;
+template class Mania::DistanceObjectPatternGenerator<9>;
+template class Mania::DistanceObjectPatternGenerator<10>;
\ No newline at end of file
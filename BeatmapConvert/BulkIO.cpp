@@ -0,0 +1,566 @@
+#include "include/BulkIO.hpp"
+#include <fstream>
+#include <iterator>
+#include <numeric>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#ifdef __linux__
+#include <linux/io_uring.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#endif
+
+namespace
+{
+    /**
+     * @brief Largest read or write of one operation, which takes a 32 bit length
+     */
+    constexpr size_t MaxTransfer = 1u << 30;
+
+    std::error_code LastError()
+    {
+        return { errno, std::generic_category() };
+    }
+}
+
+std::ostream& Mania::operator<<(std::ostream& os, IoBackend backend)
+{
+    switch (backend)
+    {
+        case IoBackend::Auto:       return os << "auto";
+        case IoBackend::IoUring:    return os << "io_uring";
+        case IoBackend::Blocking:   return os << "blocking";
+    }
+    return os;
+}
+
+std::optional<Mania::IoBackend> Mania::ParseIoBackend(std::string_view name)
+{
+    if (name == "auto")
+        return IoBackend::Auto;
+    if (name == "io_uring")
+        return IoBackend::IoUring;
+    if (name == "blocking")
+        return IoBackend::Blocking;
+    return {};
+}
+
+#ifdef __linux__
+namespace
+{
+    enum Operation : std::uint64_t
+    {
+        Open, Stat, Advise, Transfer, Close
+    };
+
+    /**
+     * @brief The slot of a file in flight and the operation, packed in the user data of a submission
+     */
+    constexpr std::uint64_t ToUserData(size_t slot, Operation operation)
+    {
+        return static_cast<std::uint64_t>(slot) << 3 | operation;
+    }
+
+    /**
+     * @brief A file being read or written
+     */
+    struct InFlight
+    {
+        size_t index{};
+        int fd = -1;
+        int error = 0;
+
+        /**
+         * @brief Completions to wait for before its next step
+         */
+        unsigned waiting = 0;
+
+        bool opened = false;
+        bool ended = false;
+        size_t done = 0;
+        struct statx stat {};
+        std::string content;
+    };
+}
+
+/**
+ * @brief A submission and a completion queue shared with the kernel, set up without liburing
+ */
+class Mania::BulkIO::Ring
+{
+public:
+    /**
+     * @throw std::system_error if io_uring is not allowed, or the kernel lacks an operation used here
+     */
+    explicit Ring(unsigned entries)
+    {
+        io_uring_params params{};
+        fd = static_cast<int>(syscall(__NR_io_uring_setup, entries, &params));
+        if (fd == -1)
+            throw std::system_error{ LastError(), "Cannot set up io_uring" };
+
+        try
+        {
+            map(params);
+            probe();
+        }
+        catch (...)
+        {
+            unmap();
+            ::close(fd);
+            throw;
+        }
+    }
+
+    ~Ring()
+    {
+        unmap();
+        ::close(fd);
+    }
+
+    Ring(Ring const&) = delete;
+    Ring& operator=(Ring const&) = delete;
+
+    /**
+     * @brief Queue a cleared submission, submitting the ones queued before if the queue is full
+     */
+    io_uring_sqe& push(std::uint8_t opcode, int file, std::uint64_t userData)
+    {
+        if (queuedTail - __atomic_load_n(sqHead, __ATOMIC_ACQUIRE) == sqEntries)
+            submit(0);
+
+        auto const index = queuedTail++ & sqMask;
+        auto& entry = sqes[index];
+        std::memset(&entry, 0, sizeof(entry));
+        entry.opcode = opcode;
+        entry.fd = file;
+        entry.user_data = userData;
+        sqArray[index] = index;
+        return entry;
+    }
+
+    /**
+     * @brief Submit the queued submissions, then wait for `waitFor` completions
+     */
+    void submit(unsigned waitFor)
+    {
+        __atomic_store_n(sqTail, queuedTail, __ATOMIC_RELEASE);
+        auto toSubmit = queuedTail - submittedTail;
+        do
+        {
+            auto const result = syscall(__NR_io_uring_enter, fd, toSubmit, waitFor, waitFor != 0 ? IORING_ENTER_GETEVENTS : 0, nullptr, 0);
+            if (result == -1)
+            {
+                if (errno == EINTR)
+                    continue;
+                throw std::system_error{ LastError(), "Cannot submit to io_uring" };
+            }
+            submittedTail += static_cast<unsigned>(result);
+            toSubmit -= static_cast<unsigned>(result);
+        } while (toSubmit != 0);
+    }
+
+    /**
+     * @brief Keep up to `depth` of `count` files in flight until every one is done
+     * @param start Queues the first operations of a file, given its slot and its index
+     * @param complete Takes the slot, the operation and the result of a completion, returns whether the slot is free again
+     */
+    template<typename Start, typename Complete>
+    void run(size_t count, unsigned depth, Start&& start, Complete&& complete)
+    {
+        std::vector<size_t> free(depth);
+        std::iota(free.rbegin(), free.rend(), size_t{});
+
+        std::vector<io_uring_cqe> completions;
+        for (size_t next = 0, inFlight = 0; next < count || inFlight != 0; )
+        {
+            for (; next < count && !free.empty(); ++next, ++inFlight)
+            {
+                start(free.back(), next);
+                free.pop_back();
+            }
+            submit(1);
+
+            /*Copied out first, so the completion queue has room while they are handled*/
+            completions.clear();
+            auto head = *cqHead;
+            for (auto const tail = __atomic_load_n(cqTail, __ATOMIC_ACQUIRE); head != tail; ++head)
+                completions.push_back(cqes[head & cqMask]);
+            __atomic_store_n(cqHead, head, __ATOMIC_RELEASE);
+
+            for (auto const& completion : completions)
+            {
+                auto const slot = static_cast<size_t>(completion.user_data >> 3);
+                if (complete(slot, static_cast<Operation>(completion.user_data & 7), completion.res))
+                {
+                    free.push_back(slot);
+                    --inFlight;
+                }
+            }
+        }
+    }
+
+private:
+    int fd = -1;
+
+    void* sqRing = MAP_FAILED;
+    size_t sqRingSize{};
+    void* cqRing = MAP_FAILED;
+    size_t cqRingSize{};
+    io_uring_sqe* sqes = static_cast<io_uring_sqe*>(MAP_FAILED);
+    size_t sqesSize{};
+
+    unsigned* sqHead{};
+    unsigned* sqTail{};
+    unsigned sqMask{};
+    unsigned sqEntries{};
+    unsigned* sqArray{};
+    unsigned* cqHead{};
+    unsigned* cqTail{};
+    unsigned cqMask{};
+    io_uring_cqe* cqes{};
+
+    /**
+     * @brief Tail of the submissions queued, and of the ones the kernel took
+     */
+    unsigned queuedTail{};
+    unsigned submittedTail{};
+
+    void map(io_uring_params const& params)
+    {
+        sqRingSize = params.sq_off.array + params.sq_entries * sizeof(unsigned);
+        cqRingSize = params.cq_off.cqes + params.cq_entries * sizeof(io_uring_cqe);
+        auto const singleMap = (params.features & IORING_FEAT_SINGLE_MMAP) != 0;
+        if (singleMap)
+            sqRingSize = cqRingSize = std::max(sqRingSize, cqRingSize);
+
+        sqRing = mmap(nullptr, sqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQ_RING);
+        if (sqRing == MAP_FAILED)
+            throw std::system_error{ LastError(), "Cannot map io_uring" };
+        cqRing = singleMap ? sqRing : mmap(nullptr, cqRingSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_CQ_RING);
+        if (cqRing == MAP_FAILED)
+            throw std::system_error{ LastError(), "Cannot map io_uring" };
+        sqesSize = params.sq_entries * sizeof(io_uring_sqe);
+        sqes = static_cast<io_uring_sqe*>(mmap(nullptr, sqesSize, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, fd, IORING_OFF_SQES));
+        if (sqes == MAP_FAILED)
+            throw std::system_error{ LastError(), "Cannot map io_uring" };
+
+        constexpr auto At = [](void* ring, unsigned offset) { return reinterpret_cast<unsigned*>(static_cast<char*>(ring) + offset); };
+        sqHead = At(sqRing, params.sq_off.head);
+        sqTail = At(sqRing, params.sq_off.tail);
+        sqMask = *At(sqRing, params.sq_off.ring_mask);
+        sqEntries = *At(sqRing, params.sq_off.ring_entries);
+        sqArray = At(sqRing, params.sq_off.array);
+        cqHead = At(cqRing, params.cq_off.head);
+        cqTail = At(cqRing, params.cq_off.tail);
+        cqMask = *At(cqRing, params.cq_off.ring_mask);
+        cqes = reinterpret_cast<io_uring_cqe*>(At(cqRing, params.cq_off.cqes));
+        queuedTail = submittedTail = *sqTail;
+    }
+
+    void unmap()
+    {
+        if (sqes != MAP_FAILED)
+            munmap(sqes, sqesSize);
+        if (cqRing != MAP_FAILED && cqRing != sqRing)
+            munmap(cqRing, cqRingSize);
+        if (sqRing != MAP_FAILED)
+            munmap(sqRing, sqRingSize);
+    }
+
+    /**
+     * @brief Opening, closing and advising through io_uring came with Linux 5.6
+     */
+    void probe()
+    {
+        constexpr unsigned MaxOperations = 256;
+        std::vector<io_uring_probe_op> buffer(MaxOperations + sizeof(io_uring_probe) / sizeof(io_uring_probe_op));
+        auto const probed = reinterpret_cast<io_uring_probe*>(buffer.data());
+        if (syscall(__NR_io_uring_register, fd, IORING_REGISTER_PROBE, probed, MaxOperations) == -1)
+            throw std::system_error{ LastError(), "Cannot probe io_uring" };
+
+        for (unsigned const operation : { IORING_OP_OPENAT, IORING_OP_STATX, IORING_OP_FADVISE, IORING_OP_READ, IORING_OP_WRITE, IORING_OP_CLOSE })
+        {
+            if (operation > probed->last_op || !(probed->ops[operation].flags & IO_URING_OP_SUPPORTED))
+                throw std::system_error{ std::make_error_code(std::errc::function_not_supported), "io_uring lacks an operation" };
+        }
+    }
+};
+
+Mania::BulkIO::BulkIO(IoBackend backend, unsigned depth) : depth{ std::max(1u, depth) }
+{
+    if (backend == IoBackend::Blocking)
+        return;
+
+    try
+    {
+        /*Room for the 2 operations a file queues at once*/
+        ring = std::make_unique<Ring>(this->depth * 2);
+    }
+    catch (std::system_error const&)
+    {
+        if (backend == IoBackend::IoUring)
+            throw;
+    }
+}
+
+void Mania::BulkIO::read(std::vector<std::filesystem::path> const& paths, std::function<void(BulkRead&&)> const& onRead)
+{
+    if (!ring)
+        return readBlocking(paths, onRead);
+
+    std::vector<InFlight> files(depth);
+    auto const finish = [&](size_t slot)
+    {
+        auto& file = files[slot];
+        BulkRead read{ paths[file.index], {}, {} };
+        if (file.error != 0)
+            read.error = { file.error, std::generic_category() };
+        else
+        {
+            file.content.resize(file.done);
+            read.content = std::move(file.content);
+        }
+        onRead(std::move(read));
+
+        if (file.fd == -1)
+            return true;
+        ring->push(IORING_OP_CLOSE, file.fd, ToUserData(slot, Close));
+        file.waiting = 1;
+        return false;
+    };
+
+    ring->run(paths.size(), depth,
+        [&](size_t slot, size_t index)
+        {
+            /*Opened and measured at the same time*/
+            auto& file = files[slot] = {};
+            file.index = index;
+            auto const path = reinterpret_cast<std::uint64_t>(paths[index].c_str());
+            auto& open = ring->push(IORING_OP_OPENAT, AT_FDCWD, ToUserData(slot, Open));
+            open.addr = path;
+            open.open_flags = O_RDONLY | O_CLOEXEC;
+            auto& stat = ring->push(IORING_OP_STATX, AT_FDCWD, ToUserData(slot, Stat));
+            stat.addr = path;
+            stat.len = STATX_SIZE;
+            stat.addr2 = reinterpret_cast<std::uint64_t>(&file.stat);
+            file.waiting = 2;
+        },
+        [&](size_t slot, Operation operation, int result)
+        {
+            auto& file = files[slot];
+            if (operation == Close)
+                return true;
+
+            /*A failed hint is not an error*/
+            if (result < 0)
+            {
+                if (operation != Advise && file.error == 0)
+                    file.error = -result;
+            }
+            else if (operation == Open)
+                file.fd = result;
+            else if (operation == Transfer)
+            {
+                file.done += static_cast<size_t>(result);
+                file.ended = result == 0;
+            }
+            if (--file.waiting != 0)
+                return false;
+
+            auto const first = !file.opened;
+            if (first && file.error == 0)
+            {
+                file.opened = true;
+                file.content.resize(static_cast<size_t>(file.stat.stx_size));
+            }
+            if (file.error != 0 || file.ended || file.done == file.content.size())
+                return finish(slot);
+
+            if (first)
+            {
+                /*Linked to the read, so the hint is taken before it*/
+                auto& advise = ring->push(IORING_OP_FADVISE, file.fd, ToUserData(slot, Advise));
+                advise.fadvise_advice = POSIX_FADV_SEQUENTIAL;
+                advise.flags = IOSQE_IO_HARDLINK;
+                ++file.waiting;
+            }
+            auto& read = ring->push(IORING_OP_READ, file.fd, ToUserData(slot, Transfer));
+            read.addr = reinterpret_cast<std::uint64_t>(file.content.data() + file.done);
+            read.len = static_cast<std::uint32_t>(std::min(file.content.size() - file.done, MaxTransfer));
+            read.off = file.done;
+            ++file.waiting;
+            return false;
+        });
+}
+
+std::vector<std::error_code> Mania::BulkIO::write(std::vector<BulkWrite> const& files)
+{
+    if (!ring)
+        return writeBlocking(files);
+
+    std::vector<std::error_code> errors(files.size());
+    std::vector<InFlight> writing(depth);
+    ring->run(files.size(), depth,
+        [&](size_t slot, size_t index)
+        {
+            auto& file = writing[slot] = {};
+            file.index = index;
+            auto& open = ring->push(IORING_OP_OPENAT, AT_FDCWD, ToUserData(slot, Open));
+            open.addr = reinterpret_cast<std::uint64_t>(files[index].path.c_str());
+            open.open_flags = O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC;
+            open.len = 0644;
+            file.waiting = 1;
+        },
+        [&](size_t slot, Operation operation, int result)
+        {
+            auto& file = writing[slot];
+            if (result < 0)
+            {
+                if (file.error == 0)
+                    file.error = -result;
+            }
+            else if (operation == Open)
+                file.fd = result;
+            else if (operation == Transfer)
+            {
+                file.done += static_cast<size_t>(result);
+                if (result == 0)
+                    file.error = EIO;
+            }
+
+            auto const& content = files[file.index].content;
+            if (operation == Close || (file.fd == -1 && file.error != 0))
+            {
+                if (file.error != 0)
+                    errors[file.index] = { file.error, std::generic_category() };
+                return true;
+            }
+            if (file.error != 0 || file.done == content.size())
+            {
+                ring->push(IORING_OP_CLOSE, file.fd, ToUserData(slot, Close));
+                return false;
+            }
+
+            auto& write = ring->push(IORING_OP_WRITE, file.fd, ToUserData(slot, Transfer));
+            write.addr = reinterpret_cast<std::uint64_t>(content.data() + file.done);
+            write.len = static_cast<std::uint32_t>(std::min(content.size() - file.done, MaxTransfer));
+            write.off = file.done;
+            return false;
+        });
+    return errors;
+}
+#else
+class Mania::BulkIO::Ring {};
+
+Mania::BulkIO::BulkIO(IoBackend backend, unsigned depth) : depth{ std::max(1u, depth) }
+{
+    if (backend == IoBackend::IoUring)
+        throw std::system_error{ std::make_error_code(std::errc::function_not_supported), "io_uring is only on Linux" };
+}
+
+void Mania::BulkIO::read(std::vector<std::filesystem::path> const& paths, std::function<void(BulkRead&&)> const& onRead)
+{
+    readBlocking(paths, onRead);
+}
+
+std::vector<std::error_code> Mania::BulkIO::write(std::vector<BulkWrite> const& files)
+{
+    return writeBlocking(files);
+}
+#endif
+
+Mania::BulkIO::~BulkIO() = default;
+
+Mania::IoBackend Mania::BulkIO::getBackend() const
+{
+    return ring ? IoBackend::IoUring : IoBackend::Blocking;
+}
+
+void Mania::BulkIO::readBlocking(std::vector<std::filesystem::path> const& paths, std::function<void(BulkRead&&)> const& onRead)
+{
+    for (auto const& path : paths)
+    {
+        BulkRead read{ path, {}, {} };
+#ifndef _WIN32
+        auto const fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+        struct stat status {};
+        if (fd == -1 || fstat(fd, &status) == -1)
+            read.error = LastError();
+        else
+        {
+#ifdef POSIX_FADV_SEQUENTIAL
+            (void)posix_fadvise(fd, 0, 0, POSIX_FADV_SEQUENTIAL);
+#endif
+            read.content.resize(static_cast<size_t>(status.st_size));
+            size_t done = 0;
+            while (done < read.content.size())
+            {
+                auto const result = pread(fd, read.content.data() + done, read.content.size() - done, static_cast<off_t>(done));
+                if (result == -1 && errno == EINTR)
+                    continue;
+                if (result == -1)
+                {
+                    read.error = LastError();
+                    break;
+                }
+                if (result == 0)
+                    break;
+                done += static_cast<size_t>(result);
+            }
+            read.content.resize(read.error ? 0 : done);
+        }
+        if (fd != -1)
+            close(fd);
+#else
+        std::ifstream file{ path, std::ios::binary };
+        if (!file.is_open())
+            read.error = std::make_error_code(std::errc::no_such_file_or_directory);
+        else
+            read.content.assign(std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{});
+#endif
+        onRead(std::move(read));
+    }
+}
+
+std::vector<std::error_code> Mania::BulkIO::writeBlocking(std::vector<BulkWrite> const& files)
+{
+    std::vector<std::error_code> errors(files.size());
+    for (size_t i = 0; i < files.size(); ++i)
+    {
+        auto const& [path, content] = files[i];
+#ifndef _WIN32
+        auto const fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (fd == -1)
+        {
+            errors[i] = LastError();
+            continue;
+        }
+        for (size_t done = 0; done < content.size(); )
+        {
+            auto const result = pwrite(fd, content.data() + done, content.size() - done, static_cast<off_t>(done));
+            if (result == -1 && errno == EINTR)
+                continue;
+            if (result == -1)
+            {
+                errors[i] = LastError();
+                break;
+            }
+            done += static_cast<size_t>(result);
+        }
+        if (close(fd) == -1 && !errors[i])
+            errors[i] = LastError();
+#else
+        std::ofstream file{ path, std::ios::binary };
+        if (!file.write(content.data(), static_cast<std::streamsize>(content.size())) || (file.close(), !file))
+            errors[i] = std::make_error_code(std::errc::io_error);
+#endif
+    }
+    return errors;
+}
@@ -0,0 +1,157 @@
+#include "include/ConversionCache.hpp"
+#include "OsuParser.hpp"
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+std::ostream& Mania::operator<<(std::ostream& os, CacheStats const& stats)
+{
+    return os << stats.hits << " hits, " << stats.misses << " misses, " << stats.evictions << " evicted, "
+        << stats.entries << " maps in " << stats.bytes / 1024 << " KiB";
+}
+
+Mania::ConversionCache::ConversionCache(std::filesystem::path directory, std::uintmax_t maxBytes)
+    : directory{ std::move(directory) }, maxBytes{ maxBytes }
+{
+    std::filesystem::create_directories(this->directory);
+
+    /*Maps whose file is gone are forgotten*/
+    std::ifstream file{ this->directory / "index.tsv" };
+    std::string line;
+    while (std::getline(file, line))
+    {
+        auto const fields = details::SplitString(line, '\t');
+        if (fields.size() != 2)
+            continue;
+        try
+        {
+            auto const key = std::stoull(std::string{ fields[0] }, nullptr, 16);
+            std::error_code error;
+            auto const size = std::filesystem::file_size(getPath(key), error);
+            if (error || index.count(key))
+                continue;
+
+            entries.push_back(Entry{ key, size, std::string{ fields[1] } });
+            index.emplace(key, std::prev(entries.end()));
+            bytes += size;
+        }
+        catch (std::exception const&)
+        {
+        }
+    }
+    evict();
+}
+
+Mania::ConversionCache::~ConversionCache()
+{
+    try
+    {
+        save();
+    }
+    catch (std::exception const& e)
+    {
+        Log(LogLevel::Error, "Cannot save the conversion cache: ", e.what());
+    }
+}
+
+std::uint64_t Mania::ConversionCache::GetKey(std::string_view content, std::string_view parameters)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (auto const part : { content, parameters })
+    {
+        for (auto const c : part)
+        {
+            hash ^= static_cast<unsigned char>(c);
+            hash *= 0x100000001b3;
+        }
+    }
+    return hash;
+}
+
+std::filesystem::path Mania::ConversionCache::fetch(std::uint64_t key, std::filesystem::path const& directory)
+{
+    std::lock_guard lock{ mutex };
+    auto const found = index.find(key);
+    if (found == index.end())
+    {
+        ++misses;
+        return {};
+    }
+
+    auto const destination = directory / found->second->fileName;
+    std::error_code error;
+    std::filesystem::remove(destination, error);
+    std::filesystem::create_hard_link(getPath(key), destination, error);
+    if (error)
+    {
+        /*Another file system*/
+        error.clear();
+        std::filesystem::copy_file(getPath(key), destination, std::filesystem::copy_options::overwrite_existing, error);
+        if (error)
+        {
+            ++misses;
+            return {};
+        }
+    }
+
+    entries.splice(entries.end(), entries, found->second);
+    ++hits;
+    return destination;
+}
+
+void Mania::ConversionCache::store(std::uint64_t key, std::filesystem::path const& converted)
+{
+    std::lock_guard lock{ mutex };
+    if (index.count(key))
+        return;
+
+    std::error_code error;
+    std::filesystem::copy_file(converted, getPath(key), std::filesystem::copy_options::overwrite_existing, error);
+    if (error)
+        return;
+
+    auto const size = std::filesystem::file_size(getPath(key));
+    entries.push_back(Entry{ key, size, converted.filename().string() });
+    index.emplace(key, std::prev(entries.end()));
+    bytes += size;
+    evict();
+}
+
+void Mania::ConversionCache::save() const
+{
+    std::lock_guard lock{ mutex };
+    std::ofstream file{ directory / "index.tsv" };
+    if (!file.is_open())
+        throw std::runtime_error{ "File not writable!" };
+
+    file << std::hex;
+    for (auto const& entry : entries)
+        file << entry.key << '\t' << entry.fileName << '\n';
+}
+
+Mania::CacheStats Mania::ConversionCache::getStats() const
+{
+    std::lock_guard lock{ mutex };
+    return CacheStats{ hits, misses, evictions, entries.size(), bytes };
+}
+
+std::filesystem::path Mania::ConversionCache::getPath(std::uint64_t key) const
+{
+    std::ostringstream name;
+    name << std::hex << std::setw(16) << std::setfill('0') << key << ".cached";
+    return directory / name.str();
+}
+
+void Mania::ConversionCache::evict()
+{
+    while (bytes > maxBytes && !entries.empty())
+    {
+        auto const& oldest = entries.front();
+        std::error_code error;
+        std::filesystem::remove(getPath(oldest.key), error);
+        bytes -= oldest.size;
+        index.erase(oldest.key);
+        entries.pop_front();
+        ++evictions;
+    }
+}
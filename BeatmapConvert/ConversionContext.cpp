@@ -0,0 +1,36 @@
+#include "include/ConversionContext.hpp"
+#include <algorithm>
+#include <cmath>
+
+Mania::HitObjectContext Mania::ConversionContextBuilder::next(HitObject const& object)
+{
+    sweep.advanceTo(object.time);
+
+    HitObjectContext context{ sweep.getBeatLength(), sweep.getSliderVelocity(), sweep.isKiai(), object.time, 0 };
+    if (object.type == HitObject::Type::Slider)
+    {
+        auto const& slider = static_cast<Slider const&>(object);
+        context.endTime = static_cast<int>(std::floor(sweep.getSliderEndTime(slider, sliderMultiplier)));
+        context.segmentDuration = (context.endTime - object.time) / std::max(1, slider.slides);
+    }
+    return context;
+}
+
+Mania::ConversionContext::ConversionContext(OsuFile const& originalBeatmap)
+    : conversionDifficulty{ GetConversionDifficulty(originalBeatmap.difficulty, originalBeatmap.getCount(), originalBeatmap.getDrainTime()) }
+{
+    ConversionContextBuilder builder{ originalBeatmap.timingPoints, originalBeatmap.difficulty };
+    objects.reserve(originalBeatmap.hitObjects.size());
+    for (auto const& object : originalBeatmap.hitObjects)
+        objects.push_back(builder.next(*object));
+}
+
+double Mania::ConversionContext::GetConversionDifficulty(Difficulty const& difficulty, size_t objectCount, int drainTime)
+{
+    auto drainTimeInSec = drainTime / 1'000;
+    if (drainTimeInSec == 0)
+        drainTimeInSec = 10'000;
+
+    double value = ((difficulty.HPDrainRate + std::clamp(difficulty.approachRate, 4.f, 7.f)) / 1.5 + objectCount / drainTimeInSec * 9.f) / 38.f * 5.f / 1.15;
+    return std::min(value, 12.0);
+}
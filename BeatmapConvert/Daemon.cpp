@@ -0,0 +1,410 @@
+#include "include/Daemon.hpp"
+#include "include/BeatmapConvert.hpp"
+#include "BeatmapAnalyze/include/Density.hpp"
+#include "BeatmapAnalyze/include/Snap.hpp"
+#include "BeatmapAnalyze/include/ManiaAnalyzer.hpp"
+#include "BeatmapAnalyze/include/Lint.hpp"
+#include <system_error>
+#include <sstream>
+#ifndef _WIN32
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Split the lines `print` writes to a stream
+ */
+template<typename Print>
+static void AppendLines(std::vector<std::string>& lines, Print&& print)
+{
+    std::ostringstream os;
+    print(os);
+    std::istringstream printed{ os.str() };
+    for (std::string line; std::getline(printed, line); )
+    {
+        if (!line.empty())
+            lines.push_back(std::move(line));
+    }
+}
+
+std::vector<std::string> Mania::Daemon::execute(std::vector<std::string_view> const& fields)
+{
+    auto const& command = fields.front();
+    std::vector<std::string> lines;
+    if (command == "stats")
+    {
+        auto const stats = getStats();
+        lines.push_back("connections=" + std::to_string(stats.connections)
+            + " requests=" + std::to_string(stats.requests)
+            + " failed=" + std::to_string(stats.failed)
+            + " parsedHits=" + std::to_string(stats.parsedHits)
+            + " parsedMisses=" + std::to_string(stats.parsedMisses));
+        return lines;
+    }
+
+    if (fields.size() < 2)
+        throw std::invalid_argument{ "Missing file" };
+    std::filesystem::path const path{ std::string{ fields[1] } };
+
+    if (command == "convert")
+    {
+        std::optional<std::uint64_t> seed;
+        int keyCount = 4;
+        for (size_t i = 2; i < fields.size(); ++i)
+        {
+            auto const [name, value] = details::SplitString<2>(fields[i], '=');
+            if (name == "seed")
+                seed = std::stoull(std::string{ value });
+            else if (name == "keys")
+                keyCount = std::stoi(std::string{ value });
+            else
+                throw std::invalid_argument{ "Unknown parameter " + std::string{ fields[i] } };
+        }
+
+        auto converted = ConvertForSave(*load(path), seed, keyCount);
+        auto const output = SaveConverted(converted, path.parent_path());
+        if (output.empty())
+            throw std::runtime_error{ "File not writable!" };
+        lines.push_back(std::to_string(converted.getCount()) + " notes");
+        lines.push_back(output.string());
+        return lines;
+    }
+
+    if (command == "analyze")
+    {
+        auto const map = load(path);
+        auto const density = Analyze::AnalyzeDensity(*map);
+        lines.push_back("mode " + std::to_string(static_cast<int>(map->general.mode)));
+        lines.push_back("drain time " + std::to_string(map->getDrainTime()) + " ms");
+        lines.push_back("peak density " + std::to_string(density.peak) + " notes/s, drain normalized " + std::to_string(density.drainNormalized));
+        lines.push_back(std::to_string(Analyze::ClassifySnaps(*map).unsnapped.size()) + " unsnapped");
+        if (map->general.mode == Mode::Mania)
+            AppendLines(lines, [&map](std::ostream& os) { os << Analyze::AnalyzeMania(*map); });
+        AppendLines(lines, [&map](std::ostream& os) { os << Analyze::Lint(*map); });
+        lines.push_back(std::to_string(map->getCount()) + " objects");
+        return lines;
+    }
+
+    throw std::invalid_argument{ "Unknown command " + std::string{ command } };
+}
+
+std::string Mania::Daemon::answer(std::string_view request)
+{
+    ++requests;
+    auto const fields = details::SplitString(request, '\t');
+    std::string const id{ fields.front() };
+    try
+    {
+        if (fields.size() < 2)
+            throw std::invalid_argument{ "Missing command" };
+
+        auto const lines = execute({ fields.begin() + 1, fields.end() });
+        std::string text;
+        for (size_t i = 0; i + 1 < lines.size(); ++i)
+            text += id + "\t-\t" + lines[i] + '\n';
+        return text + id + "\tok\t" + lines.back() + '\n';
+    }
+    catch (std::exception const& e)
+    {
+        ++failed;
+        return id + "\terror\t" + e.what() + '\n';
+    }
+}
+
+std::shared_ptr<OsuFile const> Mania::Daemon::load(std::filesystem::path const& path)
+{
+    auto const modified = std::filesystem::last_write_time(path);
+    auto const size = std::filesystem::file_size(path);
+    auto const key = std::filesystem::absolute(path).lexically_normal().string();
+
+    if (options.parsedMaps != 0)
+    {
+        std::lock_guard lock{ parsedMutex };
+        if (auto const found = parsedIndex.find(key); found != parsedIndex.end())
+        {
+            if (found->second->modified == modified && found->second->size == size)
+            {
+                parsed.splice(parsed.end(), parsed, found->second);
+                ++parsedHits;
+                return found->second->map;
+            }
+            parsed.erase(found->second);
+            parsedIndex.erase(found);
+        }
+    }
+    ++parsedMisses;
+
+    std::ifstream file{ path };
+    if (!file.is_open())
+        throw std::runtime_error{ "File not readable!" };
+    std::shared_ptr<OsuFile const> map = std::make_shared<OsuFile>(file);
+    if (options.parsedMaps == 0)
+        return map;
+
+    std::lock_guard lock{ parsedMutex };
+    if (auto const found = parsedIndex.find(key); found != parsedIndex.end())
+    {
+        /*Parsed by another request meanwhile*/
+        parsed.erase(found->second);
+        parsedIndex.erase(found);
+    }
+    parsed.push_back(ParsedMap{ key, modified, size, map });
+    parsedIndex.emplace(key, std::prev(parsed.end()));
+    while (parsed.size() > options.parsedMaps)
+    {
+        parsedIndex.erase(parsed.front().path);
+        parsed.pop_front();
+    }
+    return map;
+}
+
+Mania::DaemonStats Mania::Daemon::getStats() const
+{
+    return DaemonStats{ connectionCount, requests, failed, parsedHits, parsedMisses };
+}
+
+#ifndef _WIN32
+#ifdef MSG_NOSIGNAL
+constexpr int SendFlags = MSG_NOSIGNAL;
+#else
+constexpr int SendFlags = 0;
+#endif
+
+/**
+ * @return false if the other side is gone
+ */
+static bool SendAll(int fd, std::string_view text)
+{
+    while (!text.empty())
+    {
+        auto const sent = send(fd, text.data(), text.size(), SendFlags);
+        if (sent == -1 && errno == EINTR)
+            continue;
+        if (sent <= 0)
+            return false;
+        text.remove_prefix(static_cast<size_t>(sent));
+    }
+    return true;
+}
+
+/**
+ * @brief Call `onLine` with every line received until the other side shuts down
+ */
+template<typename OnLine>
+static void ReceiveLines(int fd, OnLine&& onLine)
+{
+    std::string buffer;
+    char chunk[4096];
+    while (true)
+    {
+        auto const received = recv(fd, chunk, sizeof(chunk), 0);
+        if (received == -1 && errno == EINTR)
+            continue;
+        if (received <= 0)
+            return;
+
+        buffer.append(chunk, static_cast<size_t>(received));
+        size_t start = 0;
+        for (size_t newline; (newline = buffer.find('\n', start)) != std::string::npos; start = newline + 1)
+        {
+            auto line = buffer.substr(start, newline - start);
+            if (!line.empty() && line.back() == '\r')
+                line.pop_back();
+            if (!line.empty())
+                onLine(std::move(line));
+        }
+        buffer.erase(0, start);
+    }
+}
+
+static sockaddr_un GetAddress(std::filesystem::path const& socket)
+{
+    sockaddr_un address{};
+    address.sun_family = AF_UNIX;
+    if (socket.native().size() >= sizeof(address.sun_path))
+        throw std::system_error{ std::make_error_code(std::errc::filename_too_long), "Socket path too long" };
+    socket.native().copy(address.sun_path, socket.native().size());
+    return address;
+}
+
+struct Mania::Daemon::Connection
+{
+    Daemon& daemon;
+    int fd;
+    std::mutex sendMutex;
+
+    Connection(Daemon& daemon, int fd) : daemon{ daemon }, fd{ fd } {}
+
+    ~Connection()
+    {
+        close(fd);
+        std::lock_guard lock{ daemon.connectionsMutex };
+        --daemon.openConnections;
+        daemon.connectionClosed.notify_all();
+    }
+
+    /**
+     * @brief Send a whole answer, so the lines of concurrent answers don't interleave
+     */
+    void send(std::string_view text)
+    {
+        std::lock_guard lock{ sendMutex };
+        (void)SendAll(fd, text);
+    }
+};
+
+Mania::Daemon::Daemon(std::filesystem::path socket, DaemonOptions const& options)
+    : socket{ std::move(socket) }, options{ options }, pool{ options.threads }
+{
+    auto const address = GetAddress(this->socket);
+    auto const fail = [this](char const* what)
+    {
+        auto const error = errno;
+        if (listener != -1)
+            close(listener);
+        throw std::system_error{ error, std::generic_category(), what };
+    };
+
+    listener = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (listener == -1)
+        fail("Cannot create the socket");
+
+    std::error_code error;
+    std::filesystem::remove(this->socket, error);
+    if (bind(listener, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == -1)
+        fail("Cannot bind the socket");
+    if (listen(listener, SOMAXCONN) == -1 || pipe(wakeUp) == -1)
+        fail("Cannot listen on the socket");
+}
+
+Mania::Daemon::~Daemon()
+{
+    close(listener);
+    close(wakeUp[0]);
+    close(wakeUp[1]);
+    std::error_code error;
+    std::filesystem::remove(socket, error);
+}
+
+void Mania::Daemon::run()
+{
+    while (true)
+    {
+        pollfd fds[]{ { listener, POLLIN, 0 }, { wakeUp[0], POLLIN, 0 } };
+        if (poll(fds, std::size(fds), -1) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error{ errno, std::generic_category(), "Cannot accept connections" };
+        }
+        if (fds[1].revents & POLLIN)
+            break;
+        if (!(fds[0].revents & POLLIN))
+            continue;
+
+        auto const fd = accept(listener, nullptr, nullptr);
+        if (fd == -1)
+            continue;
+
+        auto connection = std::make_shared<Connection>(*this, fd);
+        {
+            std::lock_guard lock{ connectionsMutex };
+            ++openConnections;
+            connections.erase(
+                std::remove_if(connections.begin(), connections.end(), [](auto const& weak) { return weak.expired(); }),
+                connections.end()
+            );
+            connections.push_back(connection);
+        }
+        ++connectionCount;
+        std::thread{ [this, connection = std::move(connection)]() mutable { read(std::move(connection)); } }.detach();
+    }
+
+    /*No more request is read, the ones read are answered*/
+    std::vector<std::shared_ptr<Connection>> open;
+    {
+        std::lock_guard lock{ connectionsMutex };
+        for (auto const& weak : connections)
+        {
+            if (auto connection = weak.lock())
+                open.push_back(std::move(connection));
+        }
+    }
+    /*Released outside the lock, as the last reference closes the connection*/
+    for (auto& connection : open)
+        shutdown(connection->fd, SHUT_RD);
+    open.clear();
+
+    std::unique_lock lock{ connectionsMutex };
+    connectionClosed.wait(lock, [this] { return openConnections == 0; });
+    connections.clear();
+}
+
+void Mania::Daemon::stop()
+{
+    (void)!write(wakeUp[1], "", 1);
+}
+
+void Mania::Daemon::read(std::shared_ptr<Connection> connection)
+{
+    ReceiveLines(connection->fd, [this, &connection](std::string&& line)
+    {
+        /*Pipelined, the next request is read while this one is answered*/
+        (void)pool.submit([this, connection, line = std::move(line)] { connection->send(answer(line)); });
+    });
+}
+
+size_t Mania::RunDaemonClient(std::filesystem::path const& socket, std::vector<std::string> const& requests, std::ostream& os)
+{
+    auto const address = GetAddress(socket);
+    auto const fd = ::socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd == -1 || connect(fd, reinterpret_cast<sockaddr const*>(&address), sizeof(address)) == -1)
+    {
+        auto const error = errno;
+        if (fd != -1)
+            close(fd);
+        throw std::system_error{ error, std::generic_category(), "Cannot reach the daemon" };
+    }
+
+    std::string text;
+    for (size_t i = 0; i < requests.size(); ++i)
+        text += std::to_string(i + 1) + '\t' + requests[i] + '\n';
+    (void)SendAll(fd, text);
+    shutdown(fd, SHUT_WR);
+
+    size_t failures{};
+    ReceiveLines(fd, [&](std::string&& line)
+    {
+        os << line << std::endl;
+        if (details::SplitString<3>(line, '\t')[1] == "error")
+            ++failures;
+    });
+    close(fd);
+    return failures;
+}
+#else
+struct Mania::Daemon::Connection
+{
+};
+
+Mania::Daemon::Daemon(std::filesystem::path socket, DaemonOptions const& options)
+    : socket{ std::move(socket) }, options{ options }, pool{ 1 }
+{
+    throw std::system_error{ std::make_error_code(std::errc::function_not_supported), "The daemon needs Unix domain sockets" };
+}
+
+Mania::Daemon::~Daemon() = default;
+
+void Mania::Daemon::run() {}
+
+void Mania::Daemon::stop() {}
+
+void Mania::Daemon::read(std::shared_ptr<Connection>) {}
+
+size_t Mania::RunDaemonClient(std::filesystem::path const&, std::vector<std::string> const&, std::ostream&)
+{
+    throw std::system_error{ std::make_error_code(std::errc::function_not_supported), "The daemon needs Unix domain sockets" };
+}
+#endif
@@ -1,33 +1,59 @@
 #include "include/Mania.Pattern.hpp"
-#include <unordered_set>
 #include <algorithm>
+#include <cassert>
 
-bool Mania::Pattern::colunmHasObject(int column) const
+Mania::Pattern& Mania::Pattern::operator+=(ManiaNote const& note)
 {
-	return std::any_of(hitObjects.cbegin(), hitObjects.cend(), [column, this](auto const& objPtr) { return objPtr->getColumnIndex(totalColumn) == column; });
+	/*Shifting the mask by it would be undefined*/
+	assert(note.column >= 0 && note.column < totalColumn);
+	if (note.column < 0 || note.column >= totalColumn)
+		return *this;
+
+	notes.push_back(note);
+	columnMask |= 1u << note.column;
+	return *this;
 }
 
-int Mania::Pattern::numColumnWithObject() const
+Mania::Pattern& Mania::Pattern::operator+=(Pattern&& pattern)
 {
-	std::unordered_set<int> column;
-	for (auto const& hitObject : hitObjects)
-		column.insert(hitObject->getColumnIndex(totalColumn));
-	return static_cast<int>(column.size());
+	notes.insert(notes.end(), pattern.notes.cbegin(), pattern.notes.cend());
+	columnMask |= pattern.columnMask;
+	pattern.notes.clear();
+	pattern.columnMask = 0;
+	return *this;
 }
 
-Mania::Pattern& Mania::Pattern::operator+=(std::unique_ptr<HitObject>&& hitObject)
+Mania::PatternSummary Mania::Pattern::summarize() const
 {
-	hitObjects.emplace_back(std::move(hitObject));
-	return *this;
+	PatternSummary summary{ totalColumn };
+	summary.columnMask = columnMask;
+	summary.noteCount = static_cast<int>(notes.size());
+	if (!notes.empty())
+	{
+		summary.firstColumn = notes.front().column;
+		summary.startTime = notes.front().startTime;
+		summary.endTime = notes.front().endTime;
+		for (auto const& note : notes)
+		{
+			summary.startTime = std::min(summary.startTime, note.startTime);
+			summary.endTime = std::max(summary.endTime, note.endTime);
+		}
+	}
+	return summary;
 }
 
-Mania::Pattern& Mania::Pattern::operator+=(Pattern&& pattern)
+void Mania::Pattern::materialize(std::vector<std::unique_ptr<HitObject>>& result, HitObject const& original) const
 {
-	hitObjects.reserve(hitObjects.size() + pattern.hitObjects.size());
-	//hitObjects.insert(hitObjects.end(), pattern.hitObjects.begin(), pattern.hitObjects.end());
-	std::move(pattern.hitObjects.begin(), pattern.hitObjects.end(), std::back_inserter(hitObjects));
-	pattern.hitObjects.clear();
-	return *this;
+	result.reserve(result.size() + notes.size());
+	for (auto const& note : notes)
+	{
+		auto hitSample = note.useOriginalSample ? original.hitSample : HitObject::HitSample{};
+		auto const x = HitObject::ColumnToX(note.column, totalColumn);
+		if (note.isHold())
+			result.emplace_back(std::make_unique<Hold>(x, 192, note.startTime, note.hitSound, note.endTime, std::move(hitSample)));
+		else
+			result.emplace_back(std::make_unique<Circle>(x, 192, note.startTime, note.hitSound, std::move(hitSample)));
+	}
 }
 
 std::ostream& Mania::operator<<(std::ostream& os, Pattern::Type type)
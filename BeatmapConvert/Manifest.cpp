@@ -0,0 +1,215 @@
+#include "include/Manifest.hpp"
+#include "include/BeatmapConvert.hpp"
+#include "include/Admission.hpp"
+#include "DirectoryWalker.hpp"
+#include <set>
+#include <mutex>
+#include <sstream>
+#include <iterator>
+
+Mania::Manifest Mania::Manifest::Load(std::filesystem::path const& root)
+{
+    Manifest manifest;
+    std::ifstream file{ root / FileName };
+    std::string line;
+    while (std::getline(file, line))
+    {
+        if (line.empty() || line.front() == '#')
+            continue;
+
+        auto const fields = details::SplitString(line, '\t');
+        if (fields.size() != 6)
+            continue;
+        try
+        {
+            manifest.entries[std::string{ fields[0] }] = ManifestEntry{
+                std::stoull(std::string{ fields[1] }),
+                std::stoll(std::string{ fields[2] }),
+                std::stoull(std::string{ fields[3] }, nullptr, 16),
+                std::string{ fields[4] },
+                std::string{ fields[5] }
+            };
+        }
+        catch (std::exception const&)
+        {
+        }
+    }
+    return manifest;
+}
+
+void Mania::Manifest::save(std::filesystem::path const& root) const
+{
+    /*Written aside and renamed, so an interrupted run leaves the previous manifest*/
+    auto const path = root / FileName;
+    auto temporary = path;
+    temporary += ".tmp";
+    {
+        std::ofstream file{ temporary };
+        if (!file.is_open())
+            throw std::runtime_error{ "File not writable!" };
+
+        file << "# source\tsize\tmodified\tcontentHash\tparameters\toutput\n" << std::hex;
+        for (auto const& [source, entry] : entries)
+        {
+            file << source << '\t'
+                << std::dec << entry.size << '\t'
+                << entry.modified << '\t'
+                << std::hex << entry.contentHash << '\t'
+                << entry.parameters << '\t'
+                << entry.output << '\n';
+        }
+    }
+    std::filesystem::rename(temporary, path);
+}
+
+std::uint64_t Mania::Manifest::HashContent(std::string_view content)
+{
+    std::uint64_t hash = 0xcbf29ce484222325;
+    for (auto const c : content)
+    {
+        hash ^= static_cast<unsigned char>(c);
+        hash *= 0x100000001b3;
+    }
+    return hash;
+}
+
+std::int64_t Mania::Manifest::GetModified(std::filesystem::directory_entry const& entry)
+{
+    return static_cast<std::int64_t>(entry.last_write_time().time_since_epoch().count());
+}
+
+std::string Mania::Manifest::GetKey(std::filesystem::path const& root, std::filesystem::path const& source)
+{
+    return source.lexically_relative(root).generic_string();
+}
+
+std::string Mania::GetSaveParameters(std::optional<std::uint64_t> seed, int keyCount)
+{
+    /*The break window and short hold length are not parameters of ConvertForSave(), but change its output*/
+    std::ostringstream os;
+    os << 'v' << ConverterVersion << " keys=" << keyCount << " seed=";
+    if (seed)
+        os << *seed;
+    else
+        os << "map";
+    os << " breaks=" << BreakWindowInBeats << ',' << BreakHitObjectThreshold << " shortHolds=1/" << ShortHoldDivisor;
+    return os.str();
+}
+
+Mania::IncrementalStats Mania::ConvertIncremental(std::filesystem::path const& root, std::optional<std::uint64_t> seed, unsigned threads, ConversionCache* cache, MemoryBudget* budget)
+{
+    auto manifest = Manifest::Load(root);
+    auto const parameters = GetSaveParameters(seed);
+
+    /*Guards the manifest, the seen sources and the statistics*/
+    std::mutex mutex;
+    std::set<std::string> seen;
+    IncrementalStats stats;
+    std::vector<std::filesystem::path> sources;
+    std::vector<std::future<void>> futures;
+
+    auto const isUpToDate = [&root, &parameters](ManifestEntry const& entry)
+    {
+        return entry.parameters == parameters && std::filesystem::exists(root / entry.output);
+    };
+
+    {
+        ThreadPool pool{ threads };
+        DirectoryWalker{}.walk(root, [&](std::filesystem::directory_entry const& entry)
+        {
+            if (!ShouldConvert(entry))
+                return;
+
+            auto key = Manifest::GetKey(root, entry.path());
+            auto const size = entry.file_size();
+            auto const modified = Manifest::GetModified(entry);
+
+            std::optional<ManifestEntry> previous;
+            {
+                std::lock_guard lock{ mutex };
+                seen.insert(key);
+                if (auto const found = manifest.entries.find(key); found != manifest.entries.end())
+                {
+                    /*Unchanged without reading it*/
+                    if (found->second.size == size && found->second.modified == modified && isUpToDate(found->second))
+                    {
+                        ++stats.skipped;
+                        return;
+                    }
+                    previous = found->second;
+                }
+            }
+
+            auto future = pool.submit([&, path = entry.path(), key = std::move(key), previous = std::move(previous), size, modified]
+            {
+                /*Admitted before the text is read*/
+                auto reservation = budget ? budget->admit(EstimateConversionMemoryBound(size)) : MemoryBudget::Reservation{};
+
+                std::ifstream file{ path, std::ios::binary };
+                if (!file.is_open())
+                    throw std::runtime_error{ "File not readable!" };
+                std::string content{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+
+                ManifestEntry record{ size, modified, Manifest::HashContent(content), parameters, {} };
+                if (previous && previous->contentHash == record.contentHash && isUpToDate(*previous))
+                {
+                    /*Only touched*/
+                    record.output = previous->output;
+                    std::lock_guard lock{ mutex };
+                    manifest.entries[key] = std::move(record);
+                    ++stats.skipped;
+                    return;
+                }
+
+                reservation.shrink(EstimateConversionMemory(content));
+                record.output = Manifest::GetKey(root, ConvertAndSave(std::move(content), path, seed, cache));
+                reservation = {};
+
+                /*The difficulty name may have changed*/
+                if (previous && previous->output != record.output)
+                {
+                    std::error_code error;
+                    std::filesystem::remove(root / previous->output, error);
+                }
+
+                std::lock_guard lock{ mutex };
+                manifest.entries[key] = std::move(record);
+                ++stats.converted;
+            });
+
+            std::lock_guard lock{ mutex };
+            sources.push_back(entry.path());
+            futures.push_back(std::move(future));
+        });
+
+        for (size_t i = 0; i < futures.size(); ++i)
+        {
+            try
+            {
+                futures[i].get();
+            }
+            catch (std::exception const& e)
+            {
+                Log(LogLevel::Error, "Cannot convert ", sources[i].string(), ": ", e.what());
+                ++stats.failed;
+            }
+        }
+    }
+
+    for (auto iter = manifest.entries.begin(); iter != manifest.entries.end(); )
+    {
+        if (seen.count(iter->first))
+        {
+            ++iter;
+            continue;
+        }
+
+        std::error_code error;
+        std::filesystem::remove(root / iter->second.output, error);
+        ++stats.removed;
+        iter = manifest.entries.erase(iter);
+    }
+
+    manifest.save(root);
+    return stats;
+}
@@ -0,0 +1,407 @@
+#include "include/Pipeline.hpp"
+#include "include/BeatmapConvert.hpp"
+#include "BoundedQueue.hpp"
+#include <atomic>
+#include <thread>
+#include <chrono>
+#include <iterator>
+#include <sstream>
+
+namespace
+{
+    using Clock = std::chrono::steady_clock;
+
+    /**
+     * @brief Files a bulk reader takes at once, and most maps a bulk writer writes at once
+     */
+    constexpr size_t BulkBatch = 64;
+
+    struct ReadMap
+    {
+        std::filesystem::path path;
+        std::string content;
+    };
+
+    /**
+     * @brief A parsed or converted map, held by pointer so the queues move it cheaply
+     */
+    struct LoadedMap
+    {
+        std::filesystem::path path;
+        std::unique_ptr<OsuFile> map;
+    };
+
+    /**
+     * @brief Counters shared by the threads of one stage
+     */
+    class Stage
+    {
+    public:
+        Stage(char const* name, unsigned threads) : threads{ threads }, name{ name }, remaining{ threads } {}
+
+        /**
+         * @brief Run a worker until `pull` returns nothing
+         * @param pull Returns the next input, or an empty optional when there is no more
+         * @param work Returns the output of an input, or an empty optional if it failed
+         * @param push Hands an output to the next stage
+         * @param done Called by the last worker to finish, to close the queue to the next stage
+         */
+        template<typename Pull, typename Work, typename Push, typename Done>
+        void run(Pull&& pull, Work&& work, Push&& push, Done&& done)
+        {
+            Clock::duration busy{}, starved{}, blocked{};
+            while (true)
+            {
+                auto const start = Clock::now();
+                auto input = pull();
+                auto const pulled = Clock::now();
+                starved += pulled - start;
+                if (!input)
+                    break;
+
+                auto output = work(std::move(*input));
+                auto const worked = Clock::now();
+                busy += worked - pulled;
+                count(output.has_value());
+                if (!output)
+                    continue;
+                push(std::move(*output));
+                blocked += Clock::now() - worked;
+            }
+            finish(busy, starved, blocked, std::forward<Done>(done));
+        }
+
+        /**
+         * @brief Count a map handled by a worker that does not go through `run()`
+         */
+        void count(bool succeeded)
+        {
+            ++items;
+            if (!succeeded)
+                ++failed;
+        }
+
+        /**
+         * @brief Add the times of a worker, the last one to finish calls `done`
+         */
+        template<typename Done>
+        void finish(Clock::duration busy, Clock::duration starved, Clock::duration blocked, Done&& done)
+        {
+            busyNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(busy).count();
+            starvedNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(starved).count();
+            blockedNanoseconds += std::chrono::duration_cast<std::chrono::nanoseconds>(blocked).count();
+            if (--remaining == 0)
+                done();
+        }
+
+        void samplePeak(size_t queued)
+        {
+            for (auto peak = peakQueued.load(); queued > peak && !peakQueued.compare_exchange_weak(peak, queued); )
+                ;
+        }
+
+        [[nodiscard]] Mania::StageStats getStats() const
+        {
+            constexpr auto ToSeconds = [](long long nanoseconds) { return nanoseconds / 1e9; };
+            return Mania::StageStats{
+                name,
+                threads,
+                items,
+                failed,
+                ToSeconds(busyNanoseconds),
+                ToSeconds(starvedNanoseconds),
+                ToSeconds(blockedNanoseconds),
+                peakQueued
+            };
+        }
+
+        unsigned const threads;
+
+    private:
+        char const* name;
+        std::atomic<unsigned> remaining;
+        std::atomic<size_t> items{};
+        std::atomic<size_t> failed{};
+        std::atomic<long long> busyNanoseconds{};
+        std::atomic<long long> starvedNanoseconds{};
+        std::atomic<long long> blockedNanoseconds{};
+        std::atomic<size_t> peakQueued{};
+    };
+
+    /**
+     * @brief Run `task` and report its exception as a failed conversion of `path`
+     */
+    template<typename Task>
+    auto Report(std::filesystem::path const& path, Task&& task) -> std::optional<decltype(task())>
+    {
+        try
+        {
+            return task();
+        }
+        catch (std::exception const& e)
+        {
+            Log(LogLevel::Error, "Cannot convert ", path.string(), ": ", e.what());
+            return {};
+        }
+    }
+
+    /**
+     * @brief Take from `queue` until it is closed and empty
+     */
+    template<typename T>
+    auto PullFrom(BoundedQueue<T>& queue)
+    {
+        return [&queue]() -> std::optional<T>
+        {
+            T value;
+            if (!queue.pop(value))
+                return {};
+            return value;
+        };
+    }
+
+    /**
+     * @brief Push to `queue`, recording how full it gets
+     */
+    template<typename T>
+    auto PushTo(BoundedQueue<T>& queue, Stage& stage)
+    {
+        return [&queue, &stage](T&& value)
+        {
+            queue.push(std::move(value));
+            stage.samplePeak(queue.size());
+        };
+    }
+
+    /**
+     * @brief A reader taking `BulkBatch` files at a time, each handed to the parsers as soon as it is read
+     */
+    void ReadInBulk(Mania::BulkIO& io, std::vector<std::filesystem::directory_entry> const& entries, std::atomic<size_t>& nextEntry, Stage& read, BoundedQueue<ReadMap>& readQueue)
+    {
+        auto const start = Clock::now();
+        Clock::duration blocked{};
+        std::vector<std::filesystem::path> batch;
+        for (size_t first; (first = nextEntry.fetch_add(BulkBatch)) < entries.size(); )
+        {
+            batch.clear();
+            for (auto i = first; i < std::min(first + BulkBatch, entries.size()); ++i)
+                batch.push_back(entries[i].path());
+
+            io.read(batch, [&](Mania::BulkRead&& file)
+            {
+                read.count(!file.error);
+                if (file.error)
+                {
+                    Log(LogLevel::Error, "Cannot convert ", file.path.string(), ": ", file.error.message());
+                    return;
+                }
+                auto const ready = Clock::now();
+                PushTo(readQueue, read)(ReadMap{ std::move(file.path), std::move(file.content) });
+                blocked += Clock::now() - ready;
+            });
+        }
+        read.finish(Clock::now() - start - blocked, {}, blocked, [&] { readQueue.close(); });
+    }
+
+    /**
+     * @brief A writer taking the converted maps waiting, up to `BulkBatch`, and writing them in one batch
+     */
+    void WriteInBulk(Mania::BulkIO& io, Stage& write, BoundedQueue<LoadedMap>& convertQueue)
+    {
+        Clock::duration busy{}, starved{};
+        std::vector<LoadedMap> maps;
+        std::vector<Mania::BulkWrite> files;
+        while (true)
+        {
+            auto const start = Clock::now();
+            LoadedMap converted;
+            auto const popped = convertQueue.pop(converted);
+            auto const pulled = Clock::now();
+            starved += pulled - start;
+            if (!popped)
+                break;
+
+            maps.clear();
+            files.clear();
+            maps.push_back(std::move(converted));
+            while (maps.size() < BulkBatch && convertQueue.tryPop(converted))
+                maps.push_back(std::move(converted));
+            for (auto const& [path, map] : maps)
+            {
+                std::ostringstream os;
+                map->save(os);
+                files.push_back(Mania::BulkWrite{ path.parent_path() / map->getSaveFileName(true), os.str() });
+
+                /*As in SaveConverted(), a map saved before may be a link to a cached map*/
+                std::error_code error;
+                std::filesystem::remove(files.back().path, error);
+            }
+
+            auto const errors = io.write(files);
+            for (size_t i = 0; i < maps.size(); ++i)
+            {
+                if (!errors[i])
+                {
+                    Log(LogLevel::Info, "Map saved -> ", files[i].path.string());
+                    write.count(true);
+                    continue;
+                }
+                /*Maybe because the name is too long, which SaveConverted() shortens*/
+                write.count(!Mania::SaveConverted(*maps[i].map, maps[i].path.parent_path()).empty());
+            }
+            busy += Clock::now() - pulled;
+        }
+        write.finish(busy, starved, {}, [] {});
+    }
+}
+
+double Mania::StageStats::getOccupancy(double wallSeconds) const
+{
+    return wallSeconds > 0 && threads != 0 ? busySeconds / (wallSeconds * threads) : 0;
+}
+
+std::ostream& Mania::operator<<(std::ostream& os, PipelineStats const& stats)
+{
+    os << stats.seconds << " s\n";
+    for (auto const& stage : stats.stages)
+    {
+        os << '\t' << stage.name << ": " << stage.threads << " threads, "
+            << stage.items << " maps (" << stage.failed << " failed), "
+            << stage.getOccupancy(stats.seconds) * 100 << "% busy, "
+            << "waited " << stage.starvedSeconds << " s for input and " << stage.blockedSeconds << " s for output, "
+            << "peak " << stage.peakQueued << " queued\n";
+    }
+    return os;
+}
+
+Mania::PipelineStats Mania::ConvertPipeline(std::vector<std::filesystem::directory_entry> entries, PipelineOptions const& options)
+{
+    SortLargestFirst(entries);
+
+    auto const hardwareThreads = std::max(1u, std::thread::hardware_concurrency());
+    Stage read{ "read", std::max(1u, options.readers) };
+    Stage parse{ "parse", std::max(1u, options.parsers) };
+    Stage convert{ "convert", options.converters != 0 ? options.converters : hardwareThreads };
+    Stage write{ "write", std::max(1u, options.writers) };
+
+    BoundedQueue<ReadMap> readQueue{ options.queueCapacity };
+    BoundedQueue<LoadedMap> parseQueue{ options.queueCapacity };
+    BoundedQueue<LoadedMap> convertQueue{ options.queueCapacity };
+
+    /*Made before any thread starts, so a backend that is not available is thrown here*/
+    std::vector<std::unique_ptr<BulkIO>> readerIO, writerIO;
+    for (unsigned i = 0; options.bulkIO && i < read.threads; ++i)
+        readerIO.push_back(std::make_unique<BulkIO>(*options.bulkIO, static_cast<unsigned>(BulkBatch)));
+    for (unsigned i = 0; options.bulkIO && i < write.threads; ++i)
+        writerIO.push_back(std::make_unique<BulkIO>(*options.bulkIO, static_cast<unsigned>(BulkBatch)));
+
+    auto const start = Clock::now();
+    std::vector<std::thread> threads;
+
+    std::atomic<size_t> nextEntry{};
+    for (unsigned i = 0; i < read.threads; ++i)
+    {
+        if (options.bulkIO)
+        {
+            threads.emplace_back([&, &io = *readerIO[i]] { ReadInBulk(io, entries, nextEntry, read, readQueue); });
+            continue;
+        }
+        threads.emplace_back([&]
+        {
+            read.run(
+                [&]() -> std::optional<std::filesystem::path>
+                {
+                    if (auto const index = nextEntry++; index < entries.size())
+                        return entries[index].path();
+                    return {};
+                },
+                [](std::filesystem::path&& path)
+                {
+                    return Report(path, [&]
+                    {
+                        std::ifstream file{ path, std::ios::binary };
+                        if (!file.is_open())
+                            throw std::runtime_error{ "File not readable!" };
+                        return ReadMap{ path, std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} } };
+                    });
+                },
+                PushTo(readQueue, read),
+                [&] { readQueue.close(); }
+            );
+        });
+    }
+
+    for (unsigned i = 0; i < parse.threads; ++i)
+    {
+        threads.emplace_back([&]
+        {
+            parse.run(
+                PullFrom(readQueue),
+                [](ReadMap&& read)
+                {
+                    return Report(read.path, [&]
+                    {
+                        std::istringstream stream{ std::move(read.content) };
+                        return LoadedMap{ std::move(read.path), std::make_unique<OsuFile>(stream) };
+                    });
+                },
+                PushTo(parseQueue, parse),
+                [&] { parseQueue.close(); }
+            );
+        });
+    }
+
+    for (unsigned i = 0; i < convert.threads; ++i)
+    {
+        threads.emplace_back([&]
+        {
+            convert.run(
+                PullFrom(parseQueue),
+                [&options](LoadedMap&& parsed)
+                {
+                    return Report(parsed.path, [&]
+                    {
+                        Log(LogLevel::Info, "Converting ", parsed.path);
+                        return LoadedMap{ std::move(parsed.path), std::make_unique<OsuFile>(ConvertForSave(*parsed.map, options.seed)) };
+                    });
+                },
+                PushTo(convertQueue, convert),
+                [&] { convertQueue.close(); }
+            );
+        });
+    }
+
+    for (unsigned i = 0; i < write.threads; ++i)
+    {
+        if (options.bulkIO)
+        {
+            threads.emplace_back([&, &io = *writerIO[i]] { WriteInBulk(io, write, convertQueue); });
+            continue;
+        }
+        threads.emplace_back([&]
+        {
+            write.run(
+                PullFrom(convertQueue),
+                [](LoadedMap&& converted)
+                {
+                    return Report(converted.path, [&]
+                    {
+                        if (SaveConverted(*converted.map, converted.path.parent_path()).empty())
+                            throw std::runtime_error{ "File not writable!" };
+                        return true;
+                    });
+                },
+                [](bool) {},
+                [] {}
+            );
+        });
+    }
+
+    for (auto& thread : threads)
+        thread.join();
+
+    return PipelineStats{
+        std::chrono::duration<double>(Clock::now() - start).count(),
+        { read.getStats(), parse.getStats(), convert.getStats(), write.getStats() }
+    };
+}
@@ -0,0 +1,137 @@
+#include "include/StreamConvert.hpp"
+#include "include/BeatmapConvert.hpp"
+
+Mania::StreamPrescan::StreamPrescan(std::ifstream& file)
+{
+    ManiaBeatmapConverter::SeedHash hash;
+    std::string line;
+    line.reserve(100);
+    while (details::GetLine(file, line, false))
+    {
+        if (line != "[HitObjects]")
+        {
+            header.parseSection(line, file);
+            continue;
+        }
+
+        /*Parsed like HitObject::HandleHitObjects() does, so the same lines are counted, but only one object is kept at a time*/
+        hitObjectsStart = file.tellg();
+        while (details::GetLine(file, line))
+        {
+            std::unique_ptr<HitObject> object;
+            try
+            {
+                object = HitObject::Parse(line);
+            }
+            catch (...)
+            {
+                continue;
+            }
+
+            if (objectCount++ == 0)
+                firstTime = object->time;
+            lastTime = object->time;
+            if (object->type == HitObject::Type::Slider || object->type == HitObject::Type::Spinner)
+                ++sliderOrSpinnerCount;
+            hash.add(object->time, object->x, object->y, object->type);
+        }
+    }
+    seed = hash.get();
+}
+
+int Mania::StreamPrescan::getDrainTime() const
+{
+    if (objectCount == 0 || objectCount == 1)
+        return 0;
+
+    if (auto const drainTime = lastTime - firstTime; drainTime > 0)
+        return drainTime;
+
+    throw std::logic_error{ "Drain time <= 0" };
+}
+
+float Mania::StreamPrescan::getPercentSliderOrSpinner() const
+{
+    return sliderOrSpinnerCount / static_cast<float>(objectCount);
+}
+
+size_t Mania::ManiaBeatmapConverter::convertStream(std::ifstream& source, std::ostream& destination)
+{
+    if (!context)
+        throw std::logic_error{ "convertStream() needs a converter constructed from a StreamPrescan" };
+
+    restart();
+    ConversionContextBuilder builder{ originalBeatmap.timingPoints, originalBeatmap.difficulty };
+    std::vector<std::unique_ptr<HitObject>> notes;
+    size_t noteCount{};
+
+    std::string line;
+    line.reserve(100);
+    while (details::GetLine(source, line))
+    {
+        std::unique_ptr<HitObject> original;
+        try
+        {
+            original = HitObject::Parse(line);
+        }
+        catch (...)
+        {
+            Log(LogLevel::Warning, "Parsing Line: ", line, "failed!");
+            continue;
+        }
+
+        auto const objectContext = builder.next(*original);
+        history.begin(*original);
+        (this->*generateForTarget)(*original, objectContext, history, state, notes);
+        history.end(*original, objectContext);
+
+        /*Only the notes of one original object are ever kept, the buffer is reused*/
+        for (auto const& note : notes)
+            destination << *note << '\n';
+        noteCount += notes.size();
+        notes.clear();
+    }
+    return noteCount;
+}
+
+Mania::StreamConvertResult Mania::StreamConvert(std::ifstream& source, StreamPrescan const& prescan, std::ostream& destination, StreamOptions const& options)
+{
+    ManiaBeatmapConverter converter{ prescan };
+    if (options.keyCount)
+        converter.setTargetColumn(*options.keyCount);
+    if (options.seed)
+        converter.setSeed(*options.seed);
+
+    OsuFile header{ prescan.header };
+    header.difficulty.circleSize = static_cast<float>(converter.getKeyCount());
+    header.general.mode = Mode::Mania;
+    header.metaData.version += options.versionSuffix;
+    header.saveSections(destination);
+
+    StreamConvertResult result{ converter.getKeyCount(), prescan.objectCount, 0 };
+    if (prescan.hitObjectsStart)
+    {
+        /*The pre-scan has read to the end*/
+        source.clear();
+        source.seekg(*prescan.hitObjectsStart);
+        result.noteCount = converter.convertStream(source, destination);
+    }
+    return result;
+}
+
+std::filesystem::path Mania::StreamConvert(std::filesystem::path const& source, std::optional<std::uint64_t> seed)
+{
+    std::ifstream file{ source };
+    StreamPrescan const prescan{ file };
+    StreamOptions const options{ 4, seed, "Converted" };
+
+    OsuFile named{ prescan.header };
+    named.metaData.version += options.versionSuffix;
+    auto const path = source.parent_path() / named.getSaveFileName(true);
+
+    std::ofstream destination{ path };
+    if (!destination.is_open())
+        throw std::runtime_error{ "File not writable!" };
+    StreamConvert(file, prescan, destination, options);
+    return path;
+}
@@ -0,0 +1,217 @@
+#include "include/Watch.hpp"
+#include "include/BeatmapConvert.hpp"
+#include <system_error>
+#include <iterator>
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <sys/eventfd.h>
+#include <poll.h>
+#include <unistd.h>
+#endif
+
+#ifdef __linux__
+Mania::LibraryWatcher::LibraryWatcher(std::filesystem::path root, WatchOptions options)
+    : root{ std::move(root) }, options{ std::move(options) }
+{
+    inotify = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+    wakeUp = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    finished = eventfd(0, EFD_NONBLOCK | EFD_CLOEXEC);
+    if (inotify == -1 || wakeUp == -1 || finished == -1)
+    {
+        auto const error = errno;
+        if (inotify != -1)
+            close(inotify);
+        if (wakeUp != -1)
+            close(wakeUp);
+        if (finished != -1)
+            close(finished);
+        throw std::system_error{ error, std::generic_category(), "Cannot watch the library" };
+    }
+
+    /*Only what changes from now on is converted, not the maps already there*/
+    watchTree(this->root, false);
+}
+
+Mania::LibraryWatcher::~LibraryWatcher()
+{
+    close(inotify);
+    close(wakeUp);
+    close(finished);
+}
+
+void Mania::LibraryWatcher::run()
+{
+    ThreadPool pool{ options.threads };
+    while (true)
+    {
+        pollfd fds[]{ { inotify, POLLIN, 0 }, { wakeUp, POLLIN, 0 }, { finished, POLLIN, 0 } };
+        if (poll(fds, std::size(fds), convertDue(pool)) == -1)
+        {
+            if (errno == EINTR)
+                continue;
+            throw std::system_error{ errno, std::generic_category(), "Cannot watch the library" };
+        }
+
+        if (fds[1].revents & POLLIN)
+            return;
+        if (fds[0].revents & POLLIN)
+            readEvents();
+        if (fds[2].revents & POLLIN)
+        {
+            std::uint64_t count;
+            (void)!read(finished, &count, sizeof(count));
+        }
+    }
+}
+
+void Mania::LibraryWatcher::stop()
+{
+    std::uint64_t const one = 1;
+    (void)!write(wakeUp, &one, sizeof(one));
+}
+
+void Mania::LibraryWatcher::watchTree(std::filesystem::path const& directory, bool takeExisting)
+{
+    auto const descriptor = inotify_add_watch(inotify, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO | IN_CREATE);
+    if (descriptor == -1)
+    {
+        Log(LogLevel::Warning, "Cannot watch ", directory, ": ", std::generic_category().message(errno));
+        return;
+    }
+    watched[descriptor] = directory;
+
+    /*A folder moved or extracted in may already hold maps, which have no event of their own*/
+    std::error_code error;
+    for (std::filesystem::directory_iterator iter{ directory, error }; !error && iter != std::filesystem::directory_iterator{}; iter.increment(error))
+    {
+        if (iter->is_directory(error) && !iter->is_symlink(error))
+            watchTree(iter->path(), takeExisting);
+        else if (takeExisting)
+            written(iter->path());
+    }
+}
+
+void Mania::LibraryWatcher::written(std::filesystem::path const& path)
+{
+    ++events;
+    if (!ShouldConvert(std::filesystem::directory_entry{ path }))
+    {
+        ++ignored;
+        return;
+    }
+    pending[path] = std::chrono::steady_clock::now();
+}
+
+void Mania::LibraryWatcher::readEvents()
+{
+    alignas(inotify_event) char buffer[16 * 1024];
+    while (true)
+    {
+        auto const length = read(inotify, buffer, sizeof(buffer));
+        if (length <= 0)
+            return;
+
+        for (auto position = buffer; position < buffer + length; )
+        {
+            auto const& event = *reinterpret_cast<inotify_event const*>(position);
+            position += sizeof(inotify_event) + event.len;
+
+            if (event.mask & IN_Q_OVERFLOW)
+            {
+                Log(LogLevel::Warning, "Too many changes at once, some maps are not converted");
+                continue;
+            }
+            if (event.mask & IN_IGNORED)
+            {
+                watched.erase(event.wd);
+                continue;
+            }
+            auto const directory = watched.find(event.wd);
+            if (directory == watched.end() || event.len == 0)
+                continue;
+
+            auto const path = directory->second / event.name;
+            if (event.mask & IN_ISDIR)
+            {
+                if (event.mask & (IN_CREATE | IN_MOVED_TO))
+                    watchTree(path, true);
+            }
+            /*A file being created is converted when it is closed*/
+            else if (event.mask & (IN_CLOSE_WRITE | IN_MOVED_TO))
+                written(path);
+        }
+    }
+}
+
+int Mania::LibraryWatcher::convertDue(ThreadPool& pool)
+{
+    auto const now = std::chrono::steady_clock::now();
+    std::optional<std::chrono::steady_clock::duration> next;
+    for (auto iter = pending.begin(); iter != pending.end(); )
+    {
+        if (auto const due = iter->second + options.debounce; due > now)
+        {
+            next = next ? std::min(*next, due - now) : due - now;
+            ++iter;
+            continue;
+        }
+        {
+            /*Written again while being converted, it waits for that conversion to end, which wakes run() up*/
+            std::lock_guard lock{ convertingMutex };
+            if (!converting.insert(iter->first).second)
+            {
+                ++iter;
+                continue;
+            }
+        }
+
+        (void)pool.submit([this, source = iter->first]
+        {
+            try
+            {
+                std::ifstream file{ source, std::ios::binary };
+                if (!file.is_open())
+                    throw std::runtime_error{ "File not readable!" };
+                auto const output = ConvertAndSave(std::string{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} }, source, options.seed, options.cache);
+                ++converted;
+                if (options.onConverted)
+                    options.onConverted(source, output);
+            }
+            catch (std::exception const& e)
+            {
+                Log(LogLevel::Error, "Cannot convert ", source.string(), ": ", e.what());
+                ++failed;
+            }
+            {
+                std::lock_guard lock{ convertingMutex };
+                converting.erase(source);
+            }
+            std::uint64_t const one = 1;
+            (void)!write(finished, &one, sizeof(one));
+        });
+        iter = pending.erase(iter);
+    }
+
+    if (!next)
+        return -1;
+    /*Rounded up, so the file is due when poll() returns*/
+    return static_cast<int>(std::chrono::ceil<std::chrono::milliseconds>(*next).count());
+}
+#else
+Mania::LibraryWatcher::LibraryWatcher(std::filesystem::path root, WatchOptions options)
+    : root{ std::move(root) }, options{ std::move(options) }
+{
+    throw std::system_error{ std::make_error_code(std::errc::function_not_supported), "Watching a library needs inotify" };
+}
+
+Mania::LibraryWatcher::~LibraryWatcher() = default;
+
+void Mania::LibraryWatcher::run() {}
+
+void Mania::LibraryWatcher::stop() {}
+#endif
+
+Mania::WatchStats Mania::LibraryWatcher::getStats() const
+{
+    return WatchStats{ events, ignored, converted, failed };
+}
@@ -0,0 +1,127 @@
+/*****************************************************************//**
+ * \file   Admission.hpp
+ * \brief  Starting conversions only while the memory they are estimated to take fits in a budget
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <ostream>
+#include <string_view>
+
+namespace Mania
+{
+    struct AdmissionStats
+    {
+        size_t admitted{};
+
+        /**
+         * @brief Conversions that could not start at once, and how long they waited in total
+         */
+        size_t waited{};
+        double waitSeconds{};
+
+        /**
+         * @brief Most memory admitted at once, by the estimates
+         */
+        std::uint64_t peakAdmitted{};
+
+        /**
+         * @brief See `GetPeakRss()`
+         */
+        std::uint64_t peakRss{};
+    };
+
+    std::ostream& operator<<(std::ostream& os, AdmissionStats const& stats);
+
+    /**
+     * @brief Estimated peak memory of `ConvertAndSave()` on the text of an osu file, including the text
+     * @details The text is held twice while parsed. Every byte of hit objects is parsed, copied by the converter
+     * and converted, which takes about 10 bytes. Storyboard lines are skipped by the parser, so they only count as text.
+     * The estimates are above what a counting allocator measured on the test maps.
+     */
+    [[nodiscard]] std::uint64_t EstimateConversionMemory(std::string_view content);
+
+    /**
+     * @brief Most `EstimateConversionMemory()` gives for a file of `fileSize` bytes, as if it was all hit objects
+     * @details Known before the file is read, so the text itself is counted while it is read
+     */
+    [[nodiscard]] std::uint64_t EstimateConversionMemoryBound(std::uintmax_t fileSize);
+
+    /**
+     * @brief Largest resident set size the process had so far, in bytes, 0 where it is not known
+     */
+    [[nodiscard]] std::uint64_t GetPeakRss();
+
+    /**
+     * @brief Admits conversions in the order they ask, while the sum of their estimated memory stays under a budget
+     * @details A conversion estimated over the whole budget is admitted once no other is running, so it still runs, alone.
+     * When many large maps come together, fewer run at once instead of the process running out of memory.
+     * All member functions can be called from several threads.
+     */
+    class MemoryBudget
+    {
+    public:
+        /**
+         * @brief Memory of an admitted conversion, given back to the budget when destroyed
+         */
+        class Reservation
+        {
+        public:
+            Reservation() = default;
+            Reservation(Reservation&& other) noexcept;
+            Reservation& operator=(Reservation&& other) noexcept;
+            ~Reservation();
+
+            /**
+             * @brief Give back what is over `bytes`, once a closer estimate is known. Never grows
+             */
+            void shrink(std::uint64_t bytes);
+
+        private:
+            friend class MemoryBudget;
+            Reservation(MemoryBudget& budget, std::uint64_t bytes);
+
+            MemoryBudget* budget = nullptr;
+            std::uint64_t bytes{};
+        };
+
+        explicit MemoryBudget(std::uint64_t bytes);
+
+        MemoryBudget(MemoryBudget const&) = delete;
+        MemoryBudget& operator=(MemoryBudget const&) = delete;
+
+        /**
+         * @brief Wait until the conversions that asked before are admitted and `bytes` fit in what is left
+         */
+        [[nodiscard]] Reservation admit(std::uint64_t bytes);
+
+        [[nodiscard]] std::uint64_t getBytes() const;
+
+        [[nodiscard]] AdmissionStats getStats() const;
+
+    private:
+        std::uint64_t const bytes;
+
+        mutable std::mutex mutex;
+        std::condition_variable changed;
+        std::uint64_t admitted{};
+        size_t running{};
+
+        /**
+         * @brief Tickets handed to the callers of `admit()` and the next one to admit, so they are admitted in order
+         */
+        std::uint64_t nextTicket{};
+        std::uint64_t serving{};
+
+        AdmissionStats stats;
+
+        /**
+         * @brief Give back `bytes`, and the place of a running conversion if it is `finished`
+         */
+        void release(std::uint64_t bytes, bool finished);
+    };
+}
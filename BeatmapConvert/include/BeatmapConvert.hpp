@@ -11,14 +11,24 @@
 #include <functional>
 #include <limits>
 #include <optional>
+#include <array>
+#include <utility>
 #include "OsuParser.hpp"
 #include "Mania.Pattern.hpp"
 #include "BeatmapConverter.hpp"
 #include "PatternGenerator.hpp"
+#include "ConversionContext.hpp"
+#include "StreamConvert.hpp"
+#include "ThreadPool.hpp"
+#include "BeatmapAnalyze/include/Density.hpp"
+#include "BeatmapAnalyze/include/ManiaAnalyzer.hpp"
 #include <future>
 
 namespace Mania
 {
+    class ConversionCache;
+    class MemoryBudget;
+
     enum class ColumnType
     {
         Even,
@@ -26,19 +36,38 @@ namespace Mania
         Special
     };
 
-    class HitObjectPatternGenerator : PatternGenerator
+    /**
+     * @tparam KeyCount Number of columns, or `DynamicKeyCount` to take it at run time
+     */
+    template<int KeyCount>
+    class HitObjectPatternGenerator : PatternGenerator<KeyCount>
     {
+        using Base = PatternGenerator<KeyCount>;
+        using Base::previousPattern;
+        using Base::hitObject;
+        using Base::hitObjectIndex;
+        using Base::objectContext;
+        using Base::totalColumns;
+        using Base::randomStart;
+        using Base::random;
+        using Base::getConversionDifficulty;
+        using Base::findAvailableColumn;
+        using Base::getRandomColumn;
+
     public:
         HitObjectPatternGenerator(
             HitObject const& hitObject, 
             OsuFile& beatmap, 
-            Pattern&& previousPattern,
+            PatternSummary const& previousPattern,
             int previousTime,
             Coord previousPosition,
             double density,
             Pattern::Type lastStair,
-            OsuFile const& originalBeatmap,
-            int const totalColumns
+            ConversionContext const& context,
+            int hitObjectIndex,
+            HitObjectContext const& objectContext,
+            int const totalColumns,
+            RandomEngine& random
         );
         
         /**
@@ -46,12 +75,13 @@ namespace Mania
          */
         Pattern generate() override;
 
+        using Base::getColumnStats;
+
         Pattern::Type stairType{};
 
     private:
         OsuFile& beatmap;
 
-
         Pattern::Type convertType{};
 
         void addToPattern(Pattern& pattern, int column) const;
@@ -61,8 +91,6 @@ namespace Mania
          */
         bool hasSpecialColumn() const;
 
-        int getNextColumn(int last) const;
-
     protected:
 
 
@@ -107,19 +135,40 @@ namespace Mania
 
     };
 
-    class DistanceObjectPatternGenerator : public PatternGenerator
+    /**
+     * @tparam KeyCount Number of columns, or `DynamicKeyCount` to take it at run time
+     */
+    template<int KeyCount>
+    class DistanceObjectPatternGenerator : public PatternGenerator<KeyCount>
     {
+        using Base = PatternGenerator<KeyCount>;
+        using Base::previousPattern;
+        using Base::hitObject;
+        using Base::hitObjectIndex;
+        using Base::objectContext;
+        using Base::totalColumns;
+        using Base::randomStart;
+        using Base::random;
+        using Base::getConversionDifficulty;
+        using Base::findAvailableColumn;
+        using Base::getRandomColumn;
+
     public:
         virtual Pattern generate() override;
 
         DistanceObjectPatternGenerator(
             HitObject const& hitObject,
             OsuFile& beatmap,
-            Pattern&& previousPattern,
-            OsuFile const& originalBeatmap,
-            int totalColumns
+            PatternSummary const& previousPattern,
+            ConversionContext const& context,
+            int hitObjectIndex,
+            HitObjectContext const& objectContext,
+            int totalColumns,
+            RandomEngine& random
         );
 
+        using Base::getColumnStats;
+
         int const startTime;
         
 
@@ -132,7 +181,7 @@ namespace Mania
 
         /**
          * @brief Duration of one slides
-         * @details (EndTime - StartTime) / SpanCount;
+         * @details (EndTime - StartTime) / SpanCount, precomputed in the `HitObjectContext`
          */
         int const segmentDuration;
 
@@ -147,10 +196,6 @@ namespace Mania
         Pattern generateHoldAndNormalNotes(int startTime);
 
     private:
-
-        [[nodiscard]] double getEndTime() const;
-        [[nodiscard]] double getSegmentDuration() const;
-
         /**
          * @brief Add a circle
          */
@@ -158,8 +203,7 @@ namespace Mania
             Pattern& pattern,
             int columnIndex, 
             int startTime, 
-            HitObject::HitSound hitSound = HitObject::HitSound{}, 
-            HitObject::HitSample hitSample = HitObject::HitSample{}
+            HitObject::HitSound hitSound = HitObject::HitSound{}
         );
 
         /**
@@ -170,32 +214,272 @@ namespace Mania
             int columnIndex,
             int startTime,
             int endTime,
-            HitObject::HitSound hitSound = HitObject::HitSound{},
-            HitObject::HitSample hitSample = HitObject::HitSample{}
+            HitObject::HitSound hitSound = HitObject::HitSound{}
         );
     };
 
+    /*The generators are compiled for each key count in BeatmapConvert.cpp*/
+    extern template class HitObjectPatternGenerator<DynamicKeyCount>;
+    extern template class HitObjectPatternGenerator<1>;
+    extern template class HitObjectPatternGenerator<2>;
+    extern template class HitObjectPatternGenerator<3>;
+    extern template class HitObjectPatternGenerator<4>;
+    extern template class HitObjectPatternGenerator<5>;
+    extern template class HitObjectPatternGenerator<6>;
+    extern template class HitObjectPatternGenerator<7>;
+    extern template class HitObjectPatternGenerator<8>;
+    extern template class HitObjectPatternGenerator<9>;
+    extern template class HitObjectPatternGenerator<10>;
+    extern template class DistanceObjectPatternGenerator<DynamicKeyCount>;
+    extern template class DistanceObjectPatternGenerator<1>;
+    extern template class DistanceObjectPatternGenerator<2>;
+    extern template class DistanceObjectPatternGenerator<3>;
+    extern template class DistanceObjectPatternGenerator<4>;
+    extern template class DistanceObjectPatternGenerator<5>;
+    extern template class DistanceObjectPatternGenerator<6>;
+    extern template class DistanceObjectPatternGenerator<7>;
+    extern template class DistanceObjectPatternGenerator<8>;
+    extern template class DistanceObjectPatternGenerator<9>;
+    extern template class DistanceObjectPatternGenerator<10>;
+
+    /**
+     * @brief Where `ManiaBeatmapConverter` may cut the original map to convert the parts in parallel
+     */
+    struct SegmentOptions
+    {
+        /**
+         * @brief A gap of at least this many beats between 2 objects starts a new segment, a break always does
+         */
+        double minGapInBeats = 4;
+
+        /**
+         * @brief Threads converting the segments, 0 for `std::thread::hardware_concurrency()`
+         * @note The result does not depend on it
+         */
+        unsigned threads = 0;
+    };
+
+    /**
+     * @brief Indexes of the original hit objects that start a segment, the first one is always 0
+     * @param context The context of `originalBeatmap`, for the end time and beat length of the objects
+     */
+    [[nodiscard]] std::vector<size_t> FindSegmentStarts(OsuFile const& originalBeatmap, ConversionContext const& context, double minGapInBeats);
+
+    /**
+     * @brief How `ManiaBeatmapConverter` searches for the best of several conversions
+     */
+    struct CandidateOptions
+    {
+        /**
+         * @brief Number of candidate conversions, each drawing from its own random stream split from the seed
+         */
+        int count = 8;
+
+        /**
+         * @brief Threads converting the candidates, 0 for `std::thread::hardware_concurrency()`
+         * @note The result does not depend on it
+         */
+        unsigned threads = 0;
+    };
+
+    /**
+     * @brief The candidate kept by a best-of-K conversion
+     */
+    struct CandidateScore
+    {
+        /**
+         * @brief Index of the candidate, which is also the index of its random stream
+         */
+        int index;
+
+        /**
+         * @brief `GetConversionPenalty()` of the candidate
+         */
+        double penalty;
+    };
+
+    /**
+     * @brief How bad a converted map plays, lower is better
+     * @details The sum of
+     * - the column imbalance, as the coefficient of variation of the column note counts
+     * - the jack density, as jacks per note
+     * - the chord spikes, as rows of more than half the keys (and at least 3 notes) per note
+     */
+    [[nodiscard]] double GetConversionPenalty(Analyze::ManiaAnalysis const& analysis);
+
     class ManiaBeatmapConverter : public BeatmapConverter
     {
     public:
 
         ManiaBeatmapConverter(OsuFile const& originalBeatmap);
 
+        /**
+         * @brief Convert the map of `prescan` with `convertStream()`
+         * @details The key count and the seed are chosen as for the whole map
+         */
+        explicit ManiaBeatmapConverter(StreamPrescan const& prescan);
+
+        /**
+         * @brief Set the key count of the converted map, between 1 and `MaxKeyCount`
+         * @param specialized Whether to use the generators compiled for `target` keys.
+         * If false, the generators taking the key count at run time are used, which gives the same result
+         */
+        ManiaBeatmapConverter& setTargetColumn(int target, bool specialized = true);
+
+        /**
+         * @brief Seed the random source of the conversion, so that the result can be reproduced
+         * @details Without it, the seed is `GetDefaultSeed(originalBeatmap)`.
+         * Every conversion starts over from the seed, so converting again gives the same map.
+         */
+        ManiaBeatmapConverter& setSeed(std::uint64_t seed);
+
+        /**
+         * @brief Convert the map in independent segments, in parallel
+         * @details The map is cut at breaks and long gaps, see `FindSegmentStarts()`.
+         * Each segment starts without a previous pattern and draws from its own random stream split from the seed,
+         * so the result only depends on the seed and `options.minGapInBeats`, but differs from a sequential conversion.
+         * @param options Empty to convert sequentially, which is the default
+         */
+        ManiaBeatmapConverter& setSegments(std::optional<SegmentOptions> options);
+
+        /**
+         * @brief Convert several candidates with different random streams in parallel, and keep the one with the lowest `GetConversionPenalty()`
+         * @details The candidates share the original map and its `ConversionContext`.
+         * A candidate is dropped as soon as a better one is found, so at most one candidate per thread and the best one are kept in memory.
+         * Ties go to the lower index, so the result only depends on the seed and `options.count`.
+         * Each candidate is converted sequentially, `setSegments()` is ignored.
+         * @param options Empty to convert once, which is the default
+         */
+        ManiaBeatmapConverter& setCandidates(std::optional<CandidateOptions> options);
 
-        ManiaBeatmapConverter& setTargetColumn(int target);
+        /**
+         * @brief A hash of the hit objects, so converting the same map twice gives the same result
+         */
+        [[nodiscard]] static std::uint64_t GetDefaultSeed(OsuFile const& originalBeatmap);
+
+        /**
+         * @brief Computes `GetDefaultSeed()` one hit object at a time
+         */
+        class SeedHash
+        {
+        public:
+            void add(int time, int x, int y, HitObject::Type type);
+
+            [[nodiscard]] std::uint64_t get() const { return hash; }
+
+        private:
+            /*FNV-1a*/
+            std::uint64_t hash = 0xcbf29ce484222325;
+
+            void combine(std::int64_t value);
+        };
 
         OsuFile convertBeatmap() override;
 
+        /**
+         * @brief Convert to each of `keyCounts` in one walk over the original objects
+         * @details The density and timing of the original objects are followed once for all the key counts.
+         * Each key count gives the same map as converting to it alone with `setTargetColumn()` and the same seed.
+         * The conversion is sequential even if `setSegments()` is used.
+         * @return The converted maps, in the order of `keyCounts`
+         */
+        std::vector<OsuFile> convertBeatmaps(std::vector<int> const& keyCounts);
+
+        /**
+         * @brief Read the hit objects of `source` one at a time and write their notes to `destination` as they are generated
+         * @details Only what is carried from one hit object to the next is kept, so the memory does not grow with the map.
+         * The converter should be constructed from the `StreamPrescan` of `source`.
+         * @param source Positioned at the first hit object line, see `StreamPrescan::hitObjectsStart`
+         * @return Number of notes written
+         */
+        size_t convertStream(std::ifstream& source, std::ostream& destination);
+
+        [[nodiscard]] int getKeyCount() const { return targetColumns; }
+
+        /**
+         * @brief Column selection counters of all the patterns generated so far
+         */
+        [[nodiscard]] ColumnSelectionStats const& getColumnStats() const { return state.columnStats; }
+
+        /**
+         * @brief The candidate kept by the last conversion with `setCandidates()`
+         */
+        [[nodiscard]] std::optional<CandidateScore> const& getBestCandidate() const { return bestCandidate; }
+
     protected:
 
+        /**
+         * @brief What the conversion remembers of the previous original objects, the same for every key count
+         */
+        struct NoteHistory
+        {
+            /**
+             * @brief Maximum number of previous notes to consider for density calculation.
+             */
+            constexpr static auto MaxNotesForDensity = 7;
+
+            int lastTime{};
+            Coord lastPosition{};
+            Analyze::RecentNoteTimes<MaxNotesForDensity> prevNoteTimes;
+            double density = std::numeric_limits<int>::max();
+
+            /**
+             * @brief Record `original` before its pattern is generated
+             */
+            void begin(HitObject const& original);
+
+            /**
+             * @brief Record `original` after its pattern is generated
+             * @param context The context of `original`
+             */
+            void end(HitObject const& original, HitObjectContext const& context);
+
+        private:
+            void recordNote(int time, Coord position);
+
+            void computeDensity(int newNoteTime);
+        };
+
+        /**
+         * @brief What the conversion to one key count carries from one hit object to the next
+         */
+        struct ConversionState
+        {
+            int keyCount;
+            Pattern::Type lastStair = Pattern::Type::Stair;
+            std::optional<PatternSummary> lastPattern;
+            RandomEngine random;
+
+            /**
+             * @brief Index of the original hit object being converted
+             */
+            int objectIndex = -1;
+
+            ColumnSelectionStats columnStats;
+
+            ConversionState(RandomEngine random, int keyCount) : keyCount{ keyCount }, random{ random } {}
+        };
+
         /**
          * @brief Performs the conversion of a hit object
          * @note This method is generally executed for all objects in a originalBeatmap
-         * @param original The hit object to convert
+         * @param original The hit object to convert, the one after the previous converted
+         * @throw std::out_of_range if every original hit object has been converted
          */
         std::vector<std::unique_ptr<HitObject>> convertHitObject(HitObject const& original) override;
 
-        std::vector<std::unique_ptr<HitObject>> generateConverted(HitObject const& original);
+        /**
+         * @brief Converts every hit object, appending the notes to one vector
+         */
+        std::vector<std::unique_ptr<HitObject>> convertHitObjects() override;
+
+        /**
+         * @brief Convert `original` and append the generated notes to `result`
+         * @tparam KeyCount `targetColumns`, or `DynamicKeyCount` to use the generators taking it at run time
+         * @note Only `state` is modified, so segments with their own state can be converted concurrently
+         */
+        template<int KeyCount>
+        void generateConverted(HitObject const& original, HitObjectContext const& objectContext, NoteHistory const& history, ConversionState& state, std::vector<std::unique_ptr<HitObject>>& result);
 
         /**
          * @brief The new converted originalBeatmap
@@ -205,13 +489,43 @@ namespace Mania
 
     private:
 
-        void recordNote(HitObject const& note);
+        using GenerateConverted = void (ManiaBeatmapConverter::*)(HitObject const&, HitObjectContext const&, NoteHistory const&, ConversionState&, std::vector<std::unique_ptr<HitObject>>&);
+
+        /**
+         * @brief `generateConverted()` compiled for `keyCount`, or the run time one if not `specialized`
+         */
+        [[nodiscard]] static GenerateConverted GetGenerateConverted(int keyCount, bool specialized);
 
-        void recordNote(int time, Coord position);
+        template<int... KeyCounts>
+        [[nodiscard]] constexpr static std::array<GenerateConverted, sizeof...(KeyCounts)> MakeGenerateConverted(std::integer_sequence<int, KeyCounts...>)
+        {
+            return { &ManiaBeatmapConverter::generateConverted<KeyCounts>... };
+        }
 
-        void computeDensity(int newNoteTime);
+        /**
+         * @brief Convert the original objects in [begin, end) with `generateForTarget`, following them in `history`
+         */
+        void convertRange(size_t begin, size_t end, NoteHistory& history, ConversionState& state, std::vector<std::unique_ptr<HitObject>>& result);
 
-        int getTargetColumn() const;
+        /**
+         * @brief Convert the segments found by `FindSegmentStarts()` in parallel and join them in order
+         */
+        std::vector<std::unique_ptr<HitObject>> convertSegments(SegmentOptions const& options);
+
+        /**
+         * @brief Convert the candidates in parallel and return the best one
+         */
+        std::vector<std::unique_ptr<HitObject>> convertCandidates(CandidateOptions const& options);
+
+        /**
+         * @brief The key count osu!lazer chooses for a map
+         */
+        [[nodiscard]] static int GetTargetColumn(float percentSliderOrSpinner, Difficulty const& difficulty);
+
+        /**
+         * @brief The converted map of `keyCount` keys with `hitObjects`
+         */
+        OsuFile makeConverted(int keyCount, std::vector<std::unique_ptr<HitObject>> hitObjects) const;
 
         //void cleanUpStackedNotes(std::vector<std::unique_ptr<HitObject>>& result) const;
 
@@ -219,45 +533,88 @@ namespace Mania
 
         /**
          * @brief Handle generated new pattern, store it into result vector, 
-         * update `lastPattern` and `lastStair` 
+         * update `lastPattern` and `lastStair` of `state`
          */
-        void handleNewPattern(Pattern pattern, Pattern::Type stairType ,std::vector<std::unique_ptr<HitObject>>& result);
+        void handleNewPattern(HitObject const& original, Pattern const& pattern, Pattern::Type stairType, ConversionState& state, std::vector<std::unique_ptr<HitObject>>& result) const;
 
         /**
-         * @brief Maximum number of previous notes to consider for density calculation.
+         * @brief Start the sequential conversion over from `seed`, keeping the column statistics
          */
-        constexpr static auto MaxNotesForDensity = 7;
+        void restart();
 
+        int targetColumns;
 
-        int lastTime{};
+        /**
+         * @brief `generateConverted()` for `targetColumns`, selected by `setTargetColumn()`
+         */
+        GenerateConverted generateForTarget;
 
-        int targetColumns;
+        std::uint64_t seed;
+
+        /**
+         * @brief State of the sequential conversion
+         */
+        NoteHistory history;
+        ConversionState state;
+
+        std::optional<SegmentOptions> segments;
 
-        Coord lastPosition{};
+        std::optional<CandidateOptions> candidates;
 
-        Pattern::Type lastStair = Pattern::Type::Stair;
-        std::optional<Pattern> lastPattern;
-        std::vector<int> prevNoteTimes;
-        double density = std::numeric_limits<int>::max();
+        std::optional<CandidateScore> bestCandidate;
+
+        /**
+         * @brief Built from the original map once per conversion, before any pattern is generated
+         */
+        std::optional<ConversionContext> context;
     };
 
     /**
      * @brief Convert all osu maps in the directory (include sub-directories) in parallel
      * @details The converted maps would be named as "<originalVersion>Converted" and saved under the same directory
+     * @param seed Seed of every conversion, if empty each map is seeded by `ManiaBeatmapConverter::GetDefaultSeed()`
+     * @param threads Number of maps converted at the same time, 0 for `std::thread::hardware_concurrency()`
      */
-    void ConvertAll(std::filesystem::recursive_directory_iterator dir);
+    void ConvertAll(std::filesystem::recursive_directory_iterator dir, std::optional<std::uint64_t> seed = {}, unsigned threads = 0);
 
      /**
      * @brief Convert all osu maps in the directory in parallel
      * @details The converted maps would be named as "<originalVersion>Converted" and saved under the same directory
+     * @param seed Seed of every conversion, if empty each map is seeded by `ManiaBeatmapConverter::GetDefaultSeed()`
+     * @param threads Number of maps converted at the same time, 0 for `std::thread::hardware_concurrency()`
      */
-    void ConvertAll(std::filesystem::directory_iterator dir);
+    void ConvertAll(std::filesystem::directory_iterator dir, std::optional<std::uint64_t> seed = {}, unsigned threads = 0);
 
     /**
      * @brief Convert all osu files in the path, which should indicate a directory in parallel
-     * @details The converted maps would be named as "<originalVersion>Converted" and saved under the same directory
+     * @details The converted maps would be named as "<originalVersion>Converted" and saved under the same directory.
+     * The directory tree is walked by a `DirectoryWalker`, and each map starts converting as soon as it is found,
+     * in the order it is found rather than the largest first.
+     * @param seed Seed of every conversion, if empty each map is seeded by `ManiaBeatmapConverter::GetDefaultSeed()`
+     * @param threads Number of maps converted at the same time, 0 for `std::thread::hardware_concurrency()`
+     * @param budget If not null, a map starts converting only once `MemoryBudget::admit()` admits it, see `ConvertImpl()`
+     */
+    void ConvertAll(std::filesystem::path path, std::optional<std::uint64_t> seed = {}, unsigned threads = 0, ConversionCache* cache = nullptr, MemoryBudget* budget = nullptr);
+
+    /**
+     * @brief Convert the osu files on a `ThreadPool` of `threads` workers, the largest file first
+     * @details Starting the longest conversions first keeps a long map from finishing alone at the end.
+     * A file that cannot be converted is reported and skipped.
+     * @param cache If not null, maps converted before are taken from it, see `ConvertAndSave()`
+     * @param budget If not null, a map starts converting only once `MemoryBudget::admit()` admits it, see `ConvertImpl()`
+     */
+    void ConvertFiles(std::vector<std::filesystem::directory_entry> entries, std::optional<std::uint64_t> seed = {}, unsigned threads = 0, ConversionCache* cache = nullptr, MemoryBudget* budget = nullptr);
+
+    /**
+     * @brief Defaults of `AddBreaks()`, which `ConvertForSave()` uses
+     */
+    constexpr int BreakWindowInBeats = 6;
+    constexpr int BreakHitObjectThreshold = 2;
+
+    /**
+     * @brief `RemoveShortHolds()` turns holds of 1/`ShortHoldDivisor` beat into circles
      */
-    void ConvertAll(std::filesystem::path path);
+    constexpr int ShortHoldDivisor = 4;
 
     /**
      * @brief Convert long section of very low density part of maps to break, using a sliding window algorithm
@@ -265,13 +622,50 @@ namespace Mania
      * @param windowSizeInBeats The sliding window sizes in terms of beats (4/4)
      * @param hitObjectCountsThreshold Specifies the minimum number of hitObjects in the window in order to not be convert into breaks
      */
-    void AddBreaks(OsuFile& beatmap, int windowSizeInBeats = 6, int hitObjectCountsThreshold = 2);
+    void AddBreaks(OsuFile& beatmap, int windowSizeInBeats = BreakWindowInBeats, int hitObjectCountsThreshold = BreakHitObjectThreshold);
 
     /**
-     * @brief Remove all 1/4 holds in the beapmap
+     * @brief Remove all 1/4 holds in the beapmap, see `ShortHoldDivisor`
      * @param beatmap The beatmap to be processed
      */
     void RemoveShortHolds(OsuFile& beatmap);
 
-    [[nodiscard]] std::future<void> ConvertImpl(std::filesystem::directory_entry const& entry);
+    /**
+     * @brief Whether `entry` is an osu file that is not converted already
+     */
+    [[nodiscard]] bool ShouldConvert(std::filesystem::directory_entry const& entry);
+
+    /**
+     * @brief Sort the files by size, the largest first, as an estimate of their conversion time
+     */
+    void SortLargestFirst(std::vector<std::filesystem::directory_entry>& entries);
+
+    /**
+     * @brief Convert a map to `keyCount` keys for saving: print its statistics, add breaks, remove short holds and lint it
+     * @details The difficulty name gets "ConvertedBreak" appended, or "<keyCount>KConvertedBreak" if `keyCount` is not 4
+     */
+    [[nodiscard]] OsuFile ConvertForSave(OsuFile const& original, std::optional<std::uint64_t> seed = {}, int keyCount = 4);
+
+    /**
+     * @brief Save a converted map under `directory` by its `OsuFile::getSaveFileName()`, with a shorter name if that fails
+     * @details A map already there is removed first rather than overwritten, as it may be a link to a cached map
+     * @return Path of the saved map, empty if it could not be saved
+     */
+    std::filesystem::path SaveConverted(OsuFile& convertedMap, std::filesystem::path const& directory);
+
+    /**
+     * @brief Convert `content`, the text of the osu file `source`, with `ConvertForSave()` and save it next to `source`
+     * @details With a `cache`, a map converted before with the same parameters is linked from the cache without being parsed,
+     * and a new conversion is stored in it.
+     * @param keyCount See `ConvertForSave()`
+     * @return Path of the converted map
+     * @throw std::runtime_error if the converted map cannot be saved
+     */
+    std::filesystem::path ConvertAndSave(std::string content, std::filesystem::path const& source, std::optional<std::uint64_t> seed = {}, ConversionCache* cache = nullptr, int keyCount = 4);
+
+    /**
+     * @brief Queue the conversion of one osu file on `pool`
+     * @param budget If not null, the file is read, then waits until its `EstimateConversionMemory()` is admitted before it is converted
+     */
+    [[nodiscard]] std::future<void> ConvertImpl(ThreadPool& pool, std::filesystem::directory_entry const& entry, std::optional<std::uint64_t> seed = {}, ConversionCache* cache = nullptr, MemoryBudget* budget = nullptr);
 }
@@ -0,0 +1,112 @@
+/*****************************************************************//**
+ * \file   BulkIO.hpp
+ * \brief  Reading and writing many small files at once, with io_uring on Linux
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <filesystem>
+#include <functional>
+#include <memory>
+#include <optional>
+#include <ostream>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace Mania
+{
+    enum class IoBackend
+    {
+        /**
+         * @brief io_uring if the kernel allows it, blocking otherwise
+         */
+        Auto,
+
+        /**
+         * @brief Opens, reads, writes and closes of many files submitted to an io_uring in batches, Linux 5.6 or later
+         */
+        IoUring,
+
+        /**
+         * @brief One file at a time with pread and pwrite
+         */
+        Blocking
+    };
+
+    std::ostream& operator<<(std::ostream& os, IoBackend backend);
+
+    /**
+     * @brief "auto", "io_uring" or "blocking"
+     */
+    [[nodiscard]] std::optional<IoBackend> ParseIoBackend(std::string_view name);
+
+    struct BulkRead
+    {
+        std::filesystem::path path;
+        std::string content;
+
+        /**
+         * @brief Set if the file could not be read, then `content` is empty
+         */
+        std::error_code error;
+    };
+
+    struct BulkWrite
+    {
+        std::filesystem::path path;
+        std::string content;
+    };
+
+    /**
+     * @brief Reads and writes whole files, keeping up to `depth` of them in flight with io_uring
+     * @details The io_uring backend needs no library, it is set up with the raw system calls.
+     * Every file read is advised as sequential with `posix_fadvise()` before its first read.
+     * An object is used by one thread at a time, each thread doing bulk I/O should have its own.
+     */
+    class BulkIO
+    {
+    public:
+        /**
+         * @param depth Most files in flight at once with io_uring
+         * @throw std::system_error if `IoBackend::IoUring` is asked for but is not available
+         */
+        explicit BulkIO(IoBackend backend = IoBackend::Auto, unsigned depth = 64);
+        ~BulkIO();
+
+        BulkIO(BulkIO const&) = delete;
+        BulkIO& operator=(BulkIO const&) = delete;
+
+        /**
+         * @brief The backend used, never `IoBackend::Auto`
+         */
+        [[nodiscard]] IoBackend getBackend() const;
+
+        /**
+         * @brief Read every file in `paths`
+         * @param onRead Called from this thread with each file as soon as it is read, in any order
+         */
+        void read(std::vector<std::filesystem::path> const& paths, std::function<void(BulkRead&&)> const& onRead);
+
+        /**
+         * @brief Create or replace every file in `files` with its content
+         * @return Error of each file, in the order of `files`, empty if it was written
+         */
+        [[nodiscard]] std::vector<std::error_code> write(std::vector<BulkWrite> const& files);
+
+    private:
+        class Ring;
+
+        /**
+         * @brief Empty when blocking
+         */
+        std::unique_ptr<Ring> ring;
+
+        unsigned depth;
+
+        void readBlocking(std::vector<std::filesystem::path> const& paths, std::function<void(BulkRead&&)> const& onRead);
+        [[nodiscard]] std::vector<std::error_code> writeBlocking(std::vector<BulkWrite> const& files);
+    };
+}
@@ -0,0 +1,112 @@
+/*****************************************************************//**
+ * \file   ConversionCache.hpp
+ * \brief  Converted maps kept by the content of their source, so a copy of a map converted before is not converted again
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <string>
+#include <string_view>
+#include <filesystem>
+#include <list>
+#include <unordered_map>
+#include <mutex>
+#include <ostream>
+#include <cstdint>
+
+namespace Mania
+{
+    struct CacheStats
+    {
+        size_t hits{};
+        size_t misses{};
+        size_t evictions{};
+        size_t entries{};
+        std::uintmax_t bytes{};
+    };
+
+    std::ostream& operator<<(std::ostream& os, CacheStats const& stats);
+
+    /**
+     * @brief A folder of converted maps, each named by the hash of its source content and conversion parameters
+     * @details The maps are saved with the ".cached" extension, so they are not converted if the folder is inside a library.
+     * A hit is hard linked to where the converted map should be saved, or copied if it cannot be linked, so it must not be edited in place.
+     * `SaveConverted()` removes a map before saving over it for that reason.
+     * When the cached maps take more than `maxBytes`, the least recently used ones are deleted.
+     * The order of use is kept in "index.tsv" of the folder between runs. All member functions can be called from several threads.
+     */
+    class ConversionCache
+    {
+    public:
+        static constexpr std::uintmax_t DefaultMaxBytes = 1ull << 30;
+
+        /**
+         * @param directory Created if it doesn't exist
+         */
+        explicit ConversionCache(std::filesystem::path directory, std::uintmax_t maxBytes = DefaultMaxBytes);
+
+        /**
+         * @brief Save the index
+         */
+        ~ConversionCache();
+
+        ConversionCache(ConversionCache const&) = delete;
+        ConversionCache& operator=(ConversionCache const&) = delete;
+
+        /**
+         * @brief FNV-1a of the source content followed by the parameters, which contain the converter version
+         * @param parameters `GetSaveParameters()` of the conversion
+         */
+        [[nodiscard]] static std::uint64_t GetKey(std::string_view content, std::string_view parameters);
+
+        /**
+         * @brief Link or copy the converted map of `key` into `directory`, under the name it was stored with
+         * @return Path of the converted map, empty on a miss
+         */
+        [[nodiscard]] std::filesystem::path fetch(std::uint64_t key, std::filesystem::path const& directory);
+
+        /**
+         * @brief Copy a converted map into the cache, then evict the least recently used maps over the size limit
+         */
+        void store(std::uint64_t key, std::filesystem::path const& converted);
+
+        void save() const;
+
+        [[nodiscard]] CacheStats getStats() const;
+
+    private:
+        struct Entry
+        {
+            std::uint64_t key;
+            std::uintmax_t size;
+
+            /**
+             * @brief File name of the converted map when it is saved, which can't be known without parsing the source
+             */
+            std::string fileName;
+        };
+
+        std::filesystem::path directory;
+        std::uintmax_t maxBytes;
+
+        mutable std::mutex mutex;
+
+        /**
+         * @brief Least recently used first
+         */
+        std::list<Entry> entries;
+        std::unordered_map<std::uint64_t, std::list<Entry>::iterator> index;
+        std::uintmax_t bytes{};
+        size_t hits{};
+        size_t misses{};
+        size_t evictions{};
+
+        [[nodiscard]] std::filesystem::path getPath(std::uint64_t key) const;
+
+        /**
+         * @brief Delete the least recently used maps until the others fit, needs `mutex`
+         */
+        void evict();
+    };
+}
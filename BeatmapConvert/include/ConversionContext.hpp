@@ -0,0 +1,89 @@
+/*****************************************************************//**
+ * \file   ConversionContext.hpp
+ * \brief  Values of the original beatmap that pattern generators need, computed once per conversion
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include "BeatmapAnalyze/include/TimingSweep.hpp"
+
+namespace Mania
+{
+    /**
+     * @brief Timing of one original hit object
+     */
+    struct HitObjectContext
+    {
+        /**
+         * @brief Beat length of the uninherited timing point in effect
+         */
+        double beatLength;
+
+        /**
+         * @brief Slider velocity multiplier of the inherited timing point in effect
+         */
+        double sliderVelocity;
+
+        bool kiai;
+
+        /**
+         * @brief End time of sliders, same as the start time for other objects
+         */
+        int endTime;
+
+        /**
+         * @brief Duration of one slide of sliders, 0 for other objects
+         */
+        int segmentDuration;
+    };
+
+    /**
+     * @brief Builds the `HitObjectContext` of hit objects one by one, in time order
+     * @details The timing points are walked with a cursor, so a whole map costs O(objects + timing points).
+     * It doesn't need the whole hit object list, so it also works when objects are read one at a time.
+     */
+    class ConversionContextBuilder
+    {
+    public:
+        ConversionContextBuilder(std::vector<TimingPoint> const& timingPoints, Difficulty const& difficulty)
+            : sweep{ timingPoints }, sliderMultiplier{ difficulty.sliderMultiplier }
+        {}
+
+        /**
+         * @note `object` should not start before the previous one
+         */
+        [[nodiscard]] HitObjectContext next(HitObject const& object);
+
+    private:
+        Analyze::TimingSweep sweep;
+        float sliderMultiplier;
+    };
+
+    /**
+     * @brief Values shared by every pattern generator of one conversion
+     */
+    struct ConversionContext
+    {
+        double conversionDifficulty;
+
+        /**
+         * @brief Context of every original hit object, in the same order
+         */
+        std::vector<HitObjectContext> objects;
+
+        explicit ConversionContext(OsuFile const& originalBeatmap);
+
+        /**
+         * @brief Without `objects`, for conversions that build the context of each object with `ConversionContextBuilder`
+         */
+        explicit ConversionContext(double conversionDifficulty) : conversionDifficulty{ conversionDifficulty } {}
+
+        /**
+         * @brief The conversion difficulty of osu!lazer, from the difficulty settings and the object density
+         * @param drainTime Drain time in milliseconds
+         */
+        [[nodiscard]] static double GetConversionDifficulty(Difficulty const& difficulty, size_t objectCount, int drainTime);
+    };
+}
@@ -0,0 +1,158 @@
+/*****************************************************************//**
+ * \file   Daemon.hpp
+ * \brief  A resident process answering conversion requests over a Unix domain socket, and its client
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include "ThreadPool.hpp"
+#include <filesystem>
+#include <memory>
+#include <mutex>
+#include <list>
+#include <unordered_map>
+#include <vector>
+#include <atomic>
+#include <condition_variable>
+#include <string>
+#include <string_view>
+
+namespace Mania
+{
+    struct DaemonOptions
+    {
+        /**
+         * @brief Number of requests answered at the same time, 0 for `std::thread::hardware_concurrency()`
+         */
+        unsigned threads = 0;
+
+        /**
+         * @brief Most parsed maps kept for later requests on the same unchanged file, 0 to parse every time
+         */
+        size_t parsedMaps = 16;
+    };
+
+    struct DaemonStats
+    {
+        size_t connections{};
+        size_t requests{};
+        size_t failed{};
+        size_t parsedHits{};
+        size_t parsedMisses{};
+    };
+
+    /**
+     * @brief Answers requests sent to a Unix domain socket, on a thread pool kept for the whole life of the process
+     * @details A request is one line of tab separated fields: "<id>\t<command>\t<arguments...>", where the id is chosen by the client.
+     * - "convert\t<file>\t[seed=<seed>]\t[keys=<keyCount>]" converts like `ConvertForSave()` and saves next to the file
+     * - "analyze\t<file>" prints the density, snapping and lint of the map, and the column statistics of an osu!mania map
+     * - "stats" prints `DaemonStats`
+     *
+     * A client can send many requests without waiting. Each is answered as soon as it completes, in any order,
+     * by zero or more "<id>\t-\t<text>" lines, then "<id>\tok\t<result>" or "<id>\terror\t<message>".
+     * A connection is closed once the client has shut down its side and every request on it is answered.
+     * Only available on Unix, elsewhere the constructor throws.
+     */
+    class Daemon
+    {
+    public:
+        /**
+         * @brief Listen on `socket`, replacing a file left there by a previous daemon
+         * @throw std::system_error if the socket cannot be listened on
+         */
+        explicit Daemon(std::filesystem::path socket, DaemonOptions const& options = {});
+
+        /**
+         * @brief Stop listening and remove the socket file
+         */
+        ~Daemon();
+
+        Daemon(Daemon const&) = delete;
+        Daemon& operator=(Daemon const&) = delete;
+
+        /**
+         * @brief Accept connections until `stop()`, then wait for the requests received
+         */
+        void run();
+
+        /**
+         * @brief Make `run()` return, can be called from any thread or a signal handler
+         */
+        void stop();
+
+        [[nodiscard]] DaemonStats getStats() const;
+
+    private:
+        struct Connection;
+
+        struct ParsedMap
+        {
+            std::string path;
+            std::filesystem::file_time_type modified;
+            std::uintmax_t size;
+            std::shared_ptr<OsuFile const> map;
+        };
+
+        std::filesystem::path socket;
+        DaemonOptions options;
+        int listener = -1;
+
+        /**
+         * @brief Read end and write end of the pipe `stop()` writes to
+         */
+        int wakeUp[2]{ -1, -1 };
+
+        /**
+         * @brief A connection is open until its requests are answered, each one is read by its own thread
+         */
+        std::mutex connectionsMutex;
+        std::condition_variable connectionClosed;
+        std::vector<std::weak_ptr<Connection>> connections;
+        size_t openConnections = 0;
+
+        /**
+         * @brief Least recently used first
+         */
+        std::list<ParsedMap> parsed;
+        std::unordered_map<std::string, std::list<ParsedMap>::iterator> parsedIndex;
+        std::mutex parsedMutex;
+
+        std::atomic<size_t> connectionCount{};
+        std::atomic<size_t> requests{};
+        std::atomic<size_t> failed{};
+        std::atomic<size_t> parsedHits{};
+        std::atomic<size_t> parsedMisses{};
+
+        /**
+         * @brief Last member, so the requests still running are answered before anything else is destroyed
+         */
+        ThreadPool pool;
+
+        void read(std::shared_ptr<Connection> connection);
+
+        /**
+         * @brief The parsed map of `path`, from the parsed maps if the file is unchanged
+         */
+        [[nodiscard]] std::shared_ptr<OsuFile const> load(std::filesystem::path const& path);
+
+        /**
+         * @brief Lines of the answer to the fields of a request after its id, the last one being the result
+         */
+        [[nodiscard]] std::vector<std::string> execute(std::vector<std::string_view> const& fields);
+
+        /**
+         * @brief Every line of the answer to one request line
+         */
+        [[nodiscard]] std::string answer(std::string_view request);
+    };
+
+    /**
+     * @brief Send `requests` to the daemon listening on `socket` without waiting, then print the answers as they arrive
+     * @param requests Each is "<command>\t<arguments...>", the ids are added
+     * @return Number of requests that failed
+     * @throw std::system_error if the daemon cannot be reached
+     */
+    size_t RunDaemonClient(std::filesystem::path const& socket, std::vector<std::string> const& requests, std::ostream& os);
+}
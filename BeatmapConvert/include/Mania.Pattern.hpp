@@ -1,8 +1,68 @@
 #pragma once
 #include "OsuParser.hpp"
+#include <bitset>
+#include <cstdint>
 
 namespace Mania
 {
+    /**
+     * @brief A note of a pattern, turned into a `Circle` or `Hold` only when the converted map is assembled
+     */
+    struct ManiaNote
+    {
+        int column;
+        int startTime;
+
+        /**
+         * @brief Same as `startTime` for circles
+         */
+        int endTime;
+
+        HitObject::HitSound hitSound{};
+
+        /**
+         * @brief Whether the note takes the hit sample of the original hit object, rather than the default one
+         */
+        bool useOriginalSample = false;
+
+        [[nodiscard]] bool isHold() const { return endTime > startTime; }
+    };
+
+    /**
+     * @brief What the next pattern generator needs to know about a pattern, without owning its notes
+     */
+    struct PatternSummary
+    {
+        int totalColumn;
+
+        /**
+         * @brief Bit i is set if column i has a note
+         */
+        std::uint32_t columnMask{};
+
+        int noteCount{};
+
+        /**
+         * @brief Column of the first note, -1 if there is no note
+         */
+        int firstColumn = -1;
+
+        int startTime{};
+        int endTime{};
+
+        PatternSummary(int totalColumn) : totalColumn{ totalColumn } {}
+
+        [[nodiscard]] bool empty() const { return noteCount == 0; }
+
+        /**
+         * @brief Determine whether the specified column has a hit object
+         * @param column The index of the column to check, starts from 0
+         */
+        bool colunmHasObject(int column) const { return (columnMask >> column) & 1u; }
+
+        int numColumnWithObject() const { return static_cast<int>(std::bitset<32>{ columnMask }.count()); }
+    };
+
     struct Pattern
     {
         enum Type : unsigned
@@ -74,9 +134,14 @@ namespace Mania
         int const totalColumn;
 
         /**
-         * @brief
+         * @brief Notes in the order they were added
+         */
+        std::vector<ManiaNote> notes;
+
+        /**
+         * @brief Bit i is set if column i has a note
          */
-        std::vector<std::unique_ptr<HitObject>> hitObjects;
+        std::uint32_t columnMask{};
 
         Pattern(int totalColumn) : totalColumn{ totalColumn } {}
 
@@ -88,19 +153,27 @@ namespace Mania
          * @brief Determine whether the specified column has a hit object
          * @param column The index of the column to check, starts from 0
          */
-        bool colunmHasObject(int column) const;
+        bool colunmHasObject(int column) const { return (columnMask >> column) & 1u; }
 
-        int numColumnWithObject() const;
+        int numColumnWithObject() const { return static_cast<int>(std::bitset<32>{ columnMask }.count()); }
 
         /**
-         * @brief Add a hit object to the pattern
+         * @brief Add a note to the pattern, a note outside of the columns is dropped
          */
-        Pattern& operator+=(std::unique_ptr<HitObject>&& hitObject);
+        Pattern& operator+=(ManiaNote const& note);
 
         /**
-         * @brief Add the hit objects contained in the pattern to this pattern
+         * @brief Add the notes contained in the pattern to this pattern
          */
         Pattern& operator+=(Pattern&& pattern);
+
+        [[nodiscard]] PatternSummary summarize() const;
+
+        /**
+         * @brief Create the `Circle` and `Hold` of every note and append them to `result`
+         * @param original The hit object the pattern is generated from, the notes with `useOriginalSample` take its hit sample
+         */
+        void materialize(std::vector<std::unique_ptr<HitObject>>& result, HitObject const& original) const;
     };
 
     std::ostream& operator<<(std::ostream& os, Pattern::Type type);
@@ -0,0 +1,122 @@
+/*****************************************************************//**
+ * \file   Manifest.hpp
+ * \brief  Record of the maps converted under a library folder, so a later run only converts what changed
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include <string>
+#include <string_view>
+#include <map>
+#include <optional>
+#include <filesystem>
+#include <cstdint>
+
+namespace Mania
+{
+    class ConversionCache;
+    class MemoryBudget;
+
+    /**
+     * @brief Bump when a change to the converter changes its output, so every map is converted again
+     */
+    constexpr int ConverterVersion = 1;
+
+    /**
+     * @brief One converted source map
+     */
+    struct ManifestEntry
+    {
+        std::uintmax_t size{};
+
+        /**
+         * @brief `std::filesystem::last_write_time()` of the source, in ticks of `std::filesystem::file_time_type`
+         */
+        std::int64_t modified{};
+
+        /**
+         * @brief `Manifest::HashContent()` of the source
+         */
+        std::uint64_t contentHash{};
+
+        /**
+         * @brief `GetSaveParameters()` of the conversion
+         */
+        std::string parameters;
+
+        /**
+         * @brief Relative to the library folder
+         */
+        std::string output;
+    };
+
+    /**
+     * @brief The converted maps of a library folder, saved as a tab separated file in the folder
+     * @details Every line holds the source, size, modified time, content hash, parameters and output separated by tabs, with paths relative to the folder.
+     * A source whose size and modification time are unchanged is not read again, one that was only touched is recognized by its content hash.
+     */
+    class Manifest
+    {
+    public:
+        static constexpr auto FileName = "Osu12Jumper.manifest.tsv";
+
+        /**
+         * @brief Read the manifest of `root`, empty if it has none
+         * @details Lines that cannot be read are dropped, so their maps are converted again
+         */
+        [[nodiscard]] static Manifest Load(std::filesystem::path const& root);
+
+        void save(std::filesystem::path const& root) const;
+
+        /**
+         * @brief FNV-1a of the whole file content
+         */
+        [[nodiscard]] static std::uint64_t HashContent(std::string_view content);
+
+        [[nodiscard]] static std::int64_t GetModified(std::filesystem::directory_entry const& entry);
+
+        /**
+         * @brief Key of the source maps, its path relative to `root` with '/' separators
+         */
+        [[nodiscard]] static std::string GetKey(std::filesystem::path const& root, std::filesystem::path const& source);
+
+        /**
+         * @brief Keyed by `GetKey()`
+         */
+        std::map<std::string, ManifestEntry> entries;
+    };
+
+    /**
+     * @brief Converter version and everything `ConvertForSave()` is given or decides, so a map converted differently is converted again
+     */
+    [[nodiscard]] std::string GetSaveParameters(std::optional<std::uint64_t> seed, int keyCount = 4);
+
+    struct IncrementalStats
+    {
+        size_t converted{};
+
+        /**
+         * @brief Unchanged since the last run
+         */
+        size_t skipped{};
+
+        /**
+         * @brief Outputs deleted because their source is gone
+         */
+        size_t removed{};
+
+        size_t failed{};
+    };
+
+    /**
+     * @brief Convert the osu files under `root` like `ConvertAll()`, skipping the ones the manifest of `root` shows as converted already
+     * @details A map is converted again if its content, the converter version or the parameters changed, or if its output is gone.
+     * The output of a map that is no longer there is deleted. The manifest is saved at the end.
+     * @param seed Seed of every conversion, if empty each map is seeded by `ManiaBeatmapConverter::GetDefaultSeed()`
+     * @param threads Number of maps converted at the same time, 0 for `std::thread::hardware_concurrency()`
+     * @param cache If not null, maps converted before are taken from it, see `ConvertAndSave()`
+     * @param budget If not null, a changed map is converted only once `MemoryBudget::admit()` admits it, see `ConvertImpl()`
+     */
+    IncrementalStats ConvertIncremental(std::filesystem::path const& root, std::optional<std::uint64_t> seed = {}, unsigned threads = 0, ConversionCache* cache = nullptr, MemoryBudget* budget = nullptr);
+}
@@ -1,24 +1,170 @@
 #pragma once
 #include "../../OsuParser.hpp"
 #include "Mania.Pattern.hpp"
+#include "RandomEngine.hpp"
+#include "ConversionContext.hpp"
 #include <functional>
 #include <optional>
+#include <initializer_list>
+#include <cassert>
+#ifdef _MSC_VER
+#include <intrin.h>
+#endif
 
 namespace Mania
 {
-	class PatternGenerator
+	/**
+	 * @brief Index of the lowest set bit, `mask` should not be 0
+	 */
+	inline int LowestSetBit(std::uint32_t mask)
+	{
+		assert(mask != 0);
+	#ifdef _MSC_VER
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return static_cast<int>(index);
+	#else
+		return __builtin_ctz(mask);
+	#endif
+	}
+
+	/**
+	 * @brief Column selection policy picking uniformly from the valid columns
+	 */
+	struct RandomColumn
+	{
+		int operator()(std::uint32_t validColumns, int /*lastColumn*/, RandomEngine& random) const
+		{
+			auto const count = static_cast<int>(std::bitset<32>{ validColumns }.count());
+			for (auto skip = random.getRand(0, count - 1); skip > 0; --skip)
+				validColumns &= validColumns - 1;
+			return LowestSetBit(validColumns);
+		}
+	};
+
+	/**
+	 * @brief Column selection policy picking the first valid column after the last one, wrapping around
+	 */
+	struct CyclicColumn
+	{
+		int operator()(std::uint32_t validColumns, int lastColumn, RandomEngine& /*random*/) const
+		{
+			auto const after = lastColumn < 0 ? validColumns : validColumns & ~((2u << lastColumn) - 1);
+			return LowestSetBit(after != 0 ? after : validColumns);
+		}
+	};
+
+	/**
+	 * @brief Column validator accepting every column
+	 */
+	struct AnyColumn
+	{
+		constexpr bool operator()(int) const { return true; }
+	};
+
+	/**
+	 * @brief Counters of `PatternGenerator::findAvailableColumn()`
+	 */
+	struct ColumnSelectionStats
+	{
+		int searches{};
+
+		/**
+		 * @brief Searches where the initial column was already valid
+		 */
+		int initialAccepted{};
+
+		/**
+		 * @brief Columns in the searched range that were rejected, because they are occupied or failed the validator
+		 */
+		int rejectedColumns{};
+
+		/**
+		 * @brief Searches where no column was valid
+		 */
+		int failed{};
+
+		ColumnSelectionStats& operator+=(ColumnSelectionStats const& rhs)
+		{
+			searches += rhs.searches;
+			initialAccepted += rhs.initialAccepted;
+			rejectedColumns += rhs.rejectedColumns;
+			failed += rhs.failed;
+			return *this;
+		}
+	};
+
+	std::ostream& operator<<(std::ostream& os, ColumnSelectionStats const& stats);
+
+	/**
+	 * @brief Key count of generators whose number of columns is only known at run time
+	 */
+	constexpr int DynamicKeyCount = 0;
+
+	/**
+	 * @brief Largest key count the generators are compiled for
+	 */
+	constexpr int MaxKeyCount = 10;
+
+	/**
+	 * @brief Number of columns of a pattern generator, a compile time constant unless `KeyCount` is `DynamicKeyCount`
+	 */
+	template<int KeyCount>
+	struct ColumnCount
+	{
+		static_assert(KeyCount > 0 && KeyCount <= MaxKeyCount);
+
+		constexpr static int totalColumns = KeyCount;
+
+		/**
+		 * @brief The first column random notes can go, column 0 of 8K is the special (scratch) column
+		 */
+		constexpr static int randomStart = KeyCount == 8 ? 1 : 0;
+
+		explicit ColumnCount([[maybe_unused]] int columns) { assert(columns == KeyCount); }
+	};
+
+	template<>
+	struct ColumnCount<DynamicKeyCount>
+	{
+		int const totalColumns;
+		int const randomStart;
+
+		explicit ColumnCount(int columns) : totalColumns{ columns }, randomStart{ columns == 8 ? 1 : 0 } {}
+	};
+
+	/**
+	 * @brief Generates a count of notes to be generated from probabilities.
+	 * @param random The random source to draw from
+	 * @param p2 Probability for 2 notes to be generated.
+	 * @param p3 Probability for 3 notes to be generated.
+	 * @param p4 Probability for 4 notes to be generated.
+	 * @param p5 Probability for 5 notes to be generated.
+	 * @param p6 Probability for 6 notes to be generated.
+	 */
+	int GetRandomNoteCount(RandomEngine& random, double p2, double p3, double p4 = 0, double p5 = 0, double p6 = 0);
+
+	/**
+	 * @tparam KeyCount Number of columns, or `DynamicKeyCount` to take it at run time
+	 */
+	template<int KeyCount>
+	class PatternGenerator : protected ColumnCount<KeyCount>
 	{
 	public:
 		/**
 		 * @brief Generate a pattern
 		 */
 		virtual Pattern generate() = 0;
+
+		[[nodiscard]] ColumnSelectionStats const& getColumnStats() const { return columnStats; }
 	protected:
+		using ColumnCount<KeyCount>::totalColumns;
+		using ColumnCount<KeyCount>::randomStart;
 
 		/**
 		 * @brief The last pattern
 		 */
-		Pattern const previousPattern;
+		PatternSummary const previousPattern;
 
 		/**
 		 * @brief The hit object to create the pattern for
@@ -26,78 +172,132 @@ namespace Mania
 		HitObject const& hitObject;
 
 		/**
-		 * @brief The originalBeatmap which `hitObject` is a part of
+		 * @brief Values of the original beatmap shared by all the generators of a conversion
 		 */
-		OsuFile const& originalBeatmap;
+		ConversionContext const& context;
 
-		int const totalColumns;
+		/**
+		 * @brief Index of `hitObject` in the original map, the generated notes use its hit sample
+		 */
+		int const hitObjectIndex;
 
-		int const randomStart;
+		/**
+		 * @brief Timing of `hitObject`
+		 */
+		HitObjectContext const& objectContext;
+
+		/**
+		 * @brief The random source of the conversion this pattern is generated for
+		 */
+		RandomEngine& random;
 
 
 		PatternGenerator(
-			Pattern&& previousPattern,
+			PatternSummary const& previousPattern,
 			HitObject const& hitObject,
-			OsuFile const& beatmap,
-			int totalColumns
-		) : previousPattern(std::move(previousPattern)),
+			ConversionContext const& context,
+			int hitObjectIndex,
+			HitObjectContext const& objectContext,
+			int totalColumns,
+			RandomEngine& random
+		) : ColumnCount<KeyCount>(totalColumns),
+			previousPattern(previousPattern),
 			hitObject(hitObject),
-			originalBeatmap(beatmap),
-			totalColumns(totalColumns),
-			randomStart(totalColumns == 8 ? 1 : 0)
+			context(context),
+			hitObjectIndex(hitObjectIndex),
+			objectContext(objectContext),
+			random(random)
 		{}
 
-		/**
-		 * @brief Generates a count of notes to be generated from probabilities.
-		 * @param p2 Probability for 2 notes to be generated.
-		 * @param p3 Probability for 3 notes to be generated.
-		 * @param p4 Probability for 4 notes to be generated.
-		 * @param p5 Probability for 5 notes to be generated.
-		 * @param p6 Probability for 6 notes to be generated.
-		 */
-		static int GetRandomNoteCount(double p2, double p3, double p4 = 0, double p5 = 0, double p6 = 0);
-
-		double getConversionDifficulty();
+		[[nodiscard]] double getConversionDifficulty() const { return context.conversionDifficulty; }
 
 		/**
 		 * @brief Finds a new column in which a HitObject can be placed.
 		 * @param initialColumn The initial column to test. This may be returned if it is already a valid column.
 		 * @param lowerBound The minimum column index. If null, `randomStart` is used.
 		 * @param upperBound The maximum column index. If null, `totalColumns` is used.
-		 * @param nextColumn A function to retrieve the next column. If null, a randomisation scheme will be used.
-		 * @param validator A function to perform additional validation checks to determine if a column is a valid candidate for a HitObject.
-		 * @param patterns A list of patterns for which the validity of a column should be checked against.
+		 * @param nextColumn The policy to pick a column from the valid ones, `RandomColumn` or `CyclicColumn`.
+		 * @param validator A predicate to perform additional validation checks to determine if a column is a valid candidate for a HitObject.
+		 * @param occupiedColumns Column masks of the patterns for which the validity of a column should be checked against.
 		 *
 		 * @details A column is not a valid candidate if a `HitObject` occupies the same column in any of the patterns.
+		 * The valid columns are collected into a bitmask once, and the policy picks one of them directly,
+		 * instead of drawing columns until one is valid as osu!lazer does.
 		 * @returns A column which has passed the `validator` check and for which there are no `HitObjects` in any of
 		 * `patterns` occupying the same column.
 		 * @retval -1 If there are no valid candidate columns.
 		 */
+		template<typename NextColumn = RandomColumn, typename Validator = AnyColumn>
 		int findAvailableColumn(
 			int initialColumn,
 			std::optional<int> lowerBound,
 			std::optional<int> upperBound,
-			std::function<int(int)> nextColumn,
-			std::function<bool(int)> validator,
-			std::vector<Pattern const*> patterns
-		) const;
+			NextColumn nextColumn,
+			Validator validator,
+			std::initializer_list<std::uint32_t> occupiedColumns
+		) const
+		{
+			++columnStats.searches;
 
-		/**
-		 * .
-		 */
-		int findAvailableColumn(int initialColumn, std::vector<Pattern const*> patterns) const;
+			std::uint32_t occupied{};
+			for (auto const mask : occupiedColumns)
+				occupied |= mask;
+
+			if (initialColumn >= 0 && !((occupied >> initialColumn) & 1u) && validator(initialColumn))
+			{
+				++columnStats.initialAccepted;
+				return initialColumn;
+			}
+
+			auto const lowBound = lowerBound.value_or(randomStart);
+			auto const upBound = upperBound.value_or(previousPattern.totalColumn - 1);
+			assert(lowBound >= 0);
+			assert(upBound < totalColumns);
+			assert(lowBound <= upBound);
+
+			std::uint32_t validColumns{};
+			for (int column = lowBound; column <= upBound; ++column)
+			{
+				if (!((occupied >> column) & 1u) && validator(column))
+					validColumns |= 1u << column;
+				else
+					++columnStats.rejectedColumns;
+			}
+
+			assert(validColumns != 0); //This should almost never happens?
+			if (validColumns == 0)
+			{
+				++columnStats.failed;
+				return -1;
+			}
+
+			auto const column = nextColumn(validColumns, initialColumn, random);
+			assert(column >= 0 && column < totalColumns);
+			return column;
+		}
+
+		int findAvailableColumn(int initialColumn, std::initializer_list<std::uint32_t> occupiedColumns) const
+		{
+			return findAvailableColumn(initialColumn, {}, {}, {}, {}, occupiedColumns);
+		}
 
 		/**
 		 * @brief Returns a random column index in the range [lowerBound, upperBound].
 		 */
-		int getRandomColumn(std::optional<int> lowerBound, std::optional<int> upperBound) const;
+		int getRandomColumn(std::optional<int> lowerBound, std::optional<int> upperBound) const
+		{
+			return random.getRand(lowerBound.value_or(randomStart), upperBound.value_or(totalColumns));
+		}
 
 		/**
 		 * @brief Returns a random column index in the range [randomStart, totalColumns].
 		 */
-		int getRandomColumn() const;
+		int getRandomColumn() const
+		{
+			return random.getRand(randomStart, totalColumns - 1);
+		}
 	private:
-		std::optional<double> conversionDifficulty;
+		mutable ColumnSelectionStats columnStats;
 	};
 
 }
\ No newline at end of file
@@ -0,0 +1,100 @@
+/*****************************************************************//**
+ * \file   Pipeline.hpp
+ * \brief  Converting many maps in read -> parse -> convert -> write stages connected by bounded queues
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include "BulkIO.hpp"
+#include <optional>
+#include <filesystem>
+#include <vector>
+
+namespace Mania
+{
+    /**
+     * @brief Threads of each stage of `ConvertPipeline()`
+     */
+    struct PipelineOptions
+    {
+        unsigned readers = 1;
+        unsigned parsers = 1;
+
+        /**
+         * @brief 0 for `std::thread::hardware_concurrency()`
+         */
+        unsigned converters = 0;
+
+        unsigned writers = 1;
+
+        /**
+         * @brief Most maps waiting between 2 stages, which bounds the memory when a stage is slower than the one before
+         * @note Rounded up to a power of 2, and at least 2, by `BoundedQueue`
+         */
+        size_t queueCapacity = 8;
+
+        /**
+         * @brief Seed of every conversion, if empty each map is seeded by `ManiaBeatmapConverter::GetDefaultSeed()`
+         */
+        std::optional<std::uint64_t> seed;
+
+        /**
+         * @brief If set, each reader keeps a batch of files in flight through `BulkIO` with this backend,
+         * and each writer writes the converted maps waiting for it in one batch
+         */
+        std::optional<IoBackend> bulkIO;
+    };
+
+    /**
+     * @brief How one stage of `ConvertPipeline()` spent its time, summed over its threads
+     */
+    struct StageStats
+    {
+        char const* name;
+        unsigned threads;
+        size_t items;
+        size_t failed;
+
+        double busySeconds;
+
+        /**
+         * @brief Waiting for the previous stage
+         */
+        double starvedSeconds;
+
+        /**
+         * @brief Waiting for room in the queue to the next stage
+         */
+        double blockedSeconds;
+
+        /**
+         * @brief Most maps seen waiting in the queue to the next stage
+         */
+        size_t peakQueued;
+
+        /**
+         * @brief Fraction of `wallSeconds` the threads of the stage were working
+         */
+        [[nodiscard]] double getOccupancy(double wallSeconds) const;
+    };
+
+    struct PipelineStats
+    {
+        double seconds;
+        std::vector<StageStats> stages;
+    };
+
+    std::ostream& operator<<(std::ostream& os, PipelineStats const& stats);
+
+    /**
+     * @brief Convert the osu files like `ConvertFiles()`, reading, parsing, converting and writing them in separate stages
+     * @details Each stage has its own threads and hands the maps to the next one through a `BoundedQueue`,
+     * so the disk and the CPUs are busy at the same time. A full queue holds back the stage before it,
+     * so however slow the writers are, at most `queueCapacity` maps, rounded up to a power of 2, wait between 2 stages.
+     * The largest files are read first.
+     * @throw std::system_error if `PipelineOptions::bulkIO` is `IoBackend::IoUring` but it is not available
+     */
+    PipelineStats ConvertPipeline(std::vector<std::filesystem::directory_entry> entries, PipelineOptions const& options = {});
+}
@@ -0,0 +1,94 @@
+/*****************************************************************//**
+ * \file   StreamConvert.hpp
+ * \brief  Converting a map while reading it, one hit object at a time
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "OsuParser.hpp"
+#include <optional>
+#include <filesystem>
+
+namespace Mania
+{
+    /**
+     * @brief What a streaming conversion needs to know about the whole map, from one pass over the file
+     * @details Every hit object line is parsed as when the whole map is loaded, so the lines the parser rejects are not counted,
+     * but only the x, y, time and type of the objects are kept
+     */
+    struct StreamPrescan
+    {
+        /**
+         * @brief Every section but the hit objects
+         */
+        OsuFile header;
+
+        /**
+         * @brief Position of the line after "[HitObjects]", empty if the file has no hit objects section
+         */
+        std::optional<std::streampos> hitObjectsStart;
+
+        size_t objectCount{};
+        size_t sliderOrSpinnerCount{};
+        int firstTime{};
+        int lastTime{};
+
+        /**
+         * @brief `ManiaBeatmapConverter::GetDefaultSeed()` of the map
+         */
+        std::uint64_t seed{};
+
+        /**
+         * @brief Read `file` to the end
+         */
+        explicit StreamPrescan(std::ifstream& file);
+
+        /**
+         * @brief Same as `OsuFile::getDrainTime()` of the whole map
+         */
+        [[nodiscard]] int getDrainTime() const;
+
+        [[nodiscard]] float getPercentSliderOrSpinner() const;
+    };
+
+    struct StreamOptions
+    {
+        /**
+         * @brief Key count of the converted map, empty to choose it like `ManiaBeatmapConverter` does for the whole map
+         */
+        std::optional<int> keyCount;
+
+        /**
+         * @brief Empty for `ManiaBeatmapConverter::GetDefaultSeed()`
+         */
+        std::optional<std::uint64_t> seed;
+
+        /**
+         * @brief Appended to the difficulty name of the converted map
+         */
+        std::string versionSuffix;
+    };
+
+    struct StreamConvertResult
+    {
+        int keyCount;
+        size_t objectCount;
+        size_t noteCount;
+    };
+
+    /**
+     * @brief Convert the map of `prescan`, writing every note to `destination` as soon as it is generated
+     * @details The notes are the same as a sequential `ManiaBeatmapConverter::convertBeatmap()` with the same key count and seed.
+     * `AddBreaks()`, `RemoveShortHolds()` and the lint need the whole converted map, so they are not done.
+     * @param source The file `prescan` is read from
+     */
+    StreamConvertResult StreamConvert(std::ifstream& source, StreamPrescan const& prescan, std::ostream& destination, StreamOptions const& options = {});
+
+    /**
+     * @brief Stream convert the map at `source` to 4 keys, like `ConvertImpl()`, and save it under the same directory
+     * @return Path of the converted map
+     * @throw std::runtime_error if the converted map cannot be written
+     */
+    std::filesystem::path StreamConvert(std::filesystem::path const& source, std::optional<std::uint64_t> seed = {});
+}
@@ -0,0 +1,141 @@
+/*****************************************************************//**
+ * \file   Watch.hpp
+ * \brief  Converting maps as they are added to or changed in a library folder
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#pragma once
+#include "ThreadPool.hpp"
+#include <filesystem>
+#include <optional>
+#include <functional>
+#include <chrono>
+#include <atomic>
+#include <map>
+#include <set>
+#include <mutex>
+#include <cstdint>
+
+namespace Mania
+{
+    class ConversionCache;
+
+    struct WatchOptions
+    {
+        /**
+         * @brief A map is converted once it has not been written to for this long, so a map written in several steps is converted once
+         */
+        std::chrono::milliseconds debounce{ 100 };
+
+        /**
+         * @brief Seed of every conversion, if empty each map is seeded by `ManiaBeatmapConverter::GetDefaultSeed()`
+         */
+        std::optional<std::uint64_t> seed;
+
+        /**
+         * @brief Number of maps converted at the same time, 0 for `std::thread::hardware_concurrency()`
+         */
+        unsigned threads = 0;
+
+        ConversionCache* cache = nullptr;
+
+        /**
+         * @brief Called from a conversion thread with the source and the converted map after each conversion
+         */
+        std::function<void(std::filesystem::path const&, std::filesystem::path const&)> onConverted;
+    };
+
+    struct WatchStats
+    {
+        size_t events{};
+
+        /**
+         * @brief Files written that are not osu files to convert, such as the converted maps
+         */
+        size_t ignored{};
+
+        size_t converted{};
+        size_t failed{};
+    };
+
+    /**
+     * @brief Watches a library folder and its sub-folders with inotify, converting every osu file written or moved into it
+     * @details Folders created later are watched too, and the maps already in them when they are found are converted.
+     * Files `ShouldConvert()` refuses, which include the converted maps, are ignored so that saving a conversion does not trigger another.
+     * Only available on Linux, elsewhere the constructor throws.
+     */
+    class LibraryWatcher
+    {
+    public:
+        /**
+         * @throw std::system_error if inotify cannot be set up
+         */
+        LibraryWatcher(std::filesystem::path root, WatchOptions options = {});
+        ~LibraryWatcher();
+
+        LibraryWatcher(LibraryWatcher const&) = delete;
+        LibraryWatcher& operator=(LibraryWatcher const&) = delete;
+
+        /**
+         * @brief Watch until `stop()`, then wait for the conversions started
+         */
+        void run();
+
+        /**
+         * @brief Make `run()` return, can be called from any thread
+         */
+        void stop();
+
+        [[nodiscard]] WatchStats getStats() const;
+
+    private:
+        std::filesystem::path root;
+        WatchOptions options;
+        int inotify = -1;
+
+        /**
+         * @brief Written by `stop()` to wake `run()` up
+         */
+        int wakeUp = -1;
+
+        /**
+         * @brief Written by a conversion when it ends, so the writes to its source meanwhile are converted next
+         */
+        int finished = -1;
+
+        std::map<int, std::filesystem::path> watched;
+
+        /**
+         * @brief Files written to, with the time of the last write
+         */
+        std::map<std::filesystem::path, std::chrono::steady_clock::time_point> pending;
+
+        /**
+         * @brief Sources being converted, which stay pending until their conversion ends so 2 never write the same output at once
+         */
+        std::set<std::filesystem::path> converting;
+        std::mutex convertingMutex;
+
+        std::atomic<size_t> events{};
+        std::atomic<size_t> ignored{};
+        std::atomic<size_t> converted{};
+        std::atomic<size_t> failed{};
+
+        /**
+         * @brief Watch `directory` and the folders in it
+         * @param takeExisting Take the files already there as written
+         */
+        void watchTree(std::filesystem::path const& directory, bool takeExisting);
+
+        void written(std::filesystem::path const& path);
+
+        void readEvents();
+
+        /**
+         * @brief Convert the pending files not written to for `WatchOptions::debounce` nor being converted
+         * @return Time until the next pending file is due, or -1 if none is pending or those due are being converted
+         */
+        int convertDue(ThreadPool& pool);
+    };
+}
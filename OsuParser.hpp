@@ -24,6 +24,7 @@
 #include <cassert>
 #include <iterator>
 #include <cstring>
+#include "Logger.hpp"
 
 //#include <queue>
 
@@ -192,7 +193,7 @@ namespace details
      * @return Return false when the file has reached the end, 
      * additionally return false when `indicateEmptyLine` is true and the file has reached an empty line.
      */
-    static inline auto GetLine(std::ifstream& file, std::string& line, bool indicateEmptyLine = true)
+    static inline auto GetLine(std::istream& file, std::string& line, bool indicateEmptyLine = true)
     {
         while (std::getline(file, line))
         {
@@ -224,7 +225,7 @@ namespace details
      * @param line The input string, and when the `target` is found, the line should contain the `target` string
      * @param file The input file stream
      */
-    static void SkipUntil(std::string_view target, std::string& line, std::ifstream& file)
+    static void SkipUntil(std::string_view target, std::string& line, std::istream& file)
     {
         do {
             if(!GetLine(file, line, false))
@@ -501,7 +502,7 @@ struct General
      * @param file The input file stream
      * @param partial Whether this is a partial parse
      */
-    General(std::ifstream& file, bool partial = true)
+    General(std::istream& file, bool partial = true)
     {
         std::string line;
         
@@ -603,7 +604,7 @@ struct Editor
      * @param file The input file stream
      * @param partial Whether this is a partial parse
      */
-    Editor(std::ifstream& file, bool partial = true)
+    Editor(std::istream& file, bool partial = true)
     {
         std::string line;
 
@@ -681,7 +682,7 @@ struct Difficulty
      * @param file The input file stream
      * @param partial Whether this is a partial parse
      */
-    Difficulty(std::ifstream& file, bool partial = true)
+    Difficulty(std::istream& file, bool partial = true)
     {
         std::string line;
 
@@ -830,7 +831,7 @@ struct TimingPoint
      * Otherwise, it tries to parse from the current line.
      * @return A `std::vector<TimingPoint>`
      */
-    static auto HandleTimingPoints(std::ifstream& file, bool partial = true)
+    static auto HandleTimingPoints(std::istream& file, bool partial = true)
     {
         std::vector<TimingPoint> timingPoints;
         std::string line;
@@ -1061,16 +1062,24 @@ public:
          *   x = columnIndex * 512 / columnCount;
         */
         assert(!(columnIndex < 0 || columnIndex >= columnCount));
+        if (columnCount == 1)
+            return 256;
         return std::clamp(columnIndex * 512 / (columnCount % 2 == 0? columnCount : columnCount - 1), 0, 512);
     }
 
+    /**
+     * @brief Parse one line of the [HitObjects] section
+     * @throw std::exception if the line is not a valid hit object
+     */
+    static std::unique_ptr<HitObject> Parse(std::string_view line);
+
     /**
      * @brief Parse hit objects
      * @param file The `.osu` file stream
      * @param partial Whether this is a partial parse, when true, it keeps reading the file until "[HitObjects]" is found
      * @return `std::vector<std::unique_ptr<HitObject>>`
      */
-    static auto HandleHitObjects(std::ifstream& file, bool partial = true)
+    static auto HandleHitObjects(std::istream& file, bool partial = true)
     {
         std::string line;
         std::vector<std::unique_ptr<HitObject>> objects;
@@ -1081,30 +1090,13 @@ public:
 
         while (details::GetLine(file, line))
         {
-            auto [_, __, ___, typeStr] = details::SplitString<4>(line);
             try
             {
-                switch (HitObject::GetType(typeStr))
-                {
-                    case Type::Circle:
-                        objects.emplace_back(std::make_unique<Circle>(line));
-                        break;
-                    case Type::Slider:
-                        objects.emplace_back(std::make_unique<Slider>(line));
-                        break;
-                    case Type::Spinner:
-                        objects.emplace_back(std::make_unique<Spinner>(line));
-                        break;
-                    case Type::Hold:
-                        objects.emplace_back(std::make_unique<Hold>(line));
-                        break;
-                    default:
-                        throw std::runtime_error{ "Hit object type not implemented" };
-                }
+                objects.emplace_back(Parse(line));
             }
             catch (...)
             {
-                std::cerr << "Parsing Line: " << line << "failed!\n";
+                Log(LogLevel::Warning, "Parsing Line: ", line, "failed!");
             }
         }
 
@@ -1157,7 +1149,7 @@ public:
     virtual ~HitObject() = default;
 
     Type type;
-protected:
+
     static inline constexpr Type GetType(int num)
     {
         if (num & CircleBit)        return Type::Circle;
@@ -1172,6 +1164,7 @@ protected:
         return GetType(std::stoi(str.data()));
     }
 
+protected:
     static inline bool IsNewCombo(int num) { return num & ComboBit; }
 
     static inline bool IsNewCombo(std::string_view str) { return IsNewCombo(std::stoi(str.data())); }
@@ -1503,6 +1496,24 @@ struct Hold final : HitObject
     }
 };
 
+inline std::unique_ptr<HitObject> HitObject::Parse(std::string_view line)
+{
+    auto [_, __, ___, typeStr] = details::SplitString<4>(line);
+    switch (HitObject::GetType(typeStr))
+    {
+        case Type::Circle:
+            return std::make_unique<Circle>(line);
+        case Type::Slider:
+            return std::make_unique<Slider>(line);
+        case Type::Spinner:
+            return std::make_unique<Spinner>(line);
+        case Type::Hold:
+            return std::make_unique<Hold>(line);
+        default:
+            throw std::runtime_error{ "Hit object type not implemented" };
+    }
+}
+
 struct Colors
 {
     struct Color
@@ -1549,7 +1560,7 @@ struct Colors
      */
     std::optional<Color> sliderBorder;
 
-    Colors(std::ifstream& file, bool partial = true)
+    Colors(std::istream& file, bool partial = true)
     {
         std::string line;
 
@@ -1647,7 +1658,7 @@ struct Metadata
      * @brief Parse Metadata from osu file
      * @param partial If this is a partial parse, it skips until "[Metadata]" line is encountered, default = `true`
      */
-    Metadata(std::ifstream& osuFile, bool partial = true)
+    Metadata(std::istream& osuFile, bool partial = true)
     {
         std::string line;
 
@@ -1867,7 +1878,7 @@ struct Events
     std::vector<Video> videos;
     std::vector<Break> breaks;
 
-    Events(std::ifstream& file, bool partial = true)
+    Events(std::istream& file, bool partial = true)
     {
         std::string line;
 
@@ -1948,23 +1959,41 @@ struct OsuFile
     Colors colors;
     std::vector<std::unique_ptr<HitObject>> hitObjects;
 
-    OsuFile(std::ifstream&& file)
+    OsuFile(std::ifstream&& file) : OsuFile{ static_cast<std::istream&>(file) }
+    {
+    }
+
+    /**
+     * @brief Parse a whole `.osu` file from any stream, eg. a `std::istringstream` of a file read in advance
+     */
+    explicit OsuFile(std::istream& file)
     {
         std::string line;
         line.reserve(100);
         while (details::GetLine(file, line, false))
         {
-            if (line == "[General]")            general = General{ file, false };
-            else if (line == "[Editor]")        editor = Editor{ file, false };
-            else if (line == "[Metadata]")      metaData = Metadata{ file, false };
-            else if (line == "[Difficulty]")    difficulty = Difficulty{ file, false };
-            else if (line == "[Events]")        events = Events(file, false);
-            else if (line == "[TimingPoints]")  timingPoints = TimingPoint::HandleTimingPoints(file, false);
-            else if (line == "[Colours]")       colors = Colors{ file, false };
-            else if (line == "[HitObjects]")    hitObjects = HitObject::HandleHitObjects(file, false);
+            if (line == "[HitObjects]")         hitObjects = HitObject::HandleHitObjects(file, false);
+            else                                parseSection(line, file);
         }
     }
 
+    /**
+     * @brief Parse the section following `line` if it is the header of one, except [HitObjects]
+     * @return Whether `line` is a section header
+     */
+    bool parseSection(std::string const& line, std::istream& file)
+    {
+        if (line == "[General]")            general = General{ file, false };
+        else if (line == "[Editor]")        editor = Editor{ file, false };
+        else if (line == "[Metadata]")      metaData = Metadata{ file, false };
+        else if (line == "[Difficulty]")    difficulty = Difficulty{ file, false };
+        else if (line == "[Events]")        events = Events(file, false);
+        else if (line == "[TimingPoints]")  timingPoints = TimingPoint::HandleTimingPoints(file, false);
+        else if (line == "[Colours]")       colors = Colors{ file, false };
+        else                                return false;
+        return true;
+    }
+
     OsuFile(General const& general, Editor const& editor, Metadata const& metaData, Difficulty const& difficulty, Events const& events, std::vector<TimingPoint> const& timingPoints = {}, Colors const& colors = {})
         : general{ general }, editor{ editor }, metaData{ metaData }, difficulty{ difficulty }, events{ events }, timingPoints{ timingPoints }, colors{ colors }
     {
@@ -2156,7 +2185,25 @@ struct OsuFile
     {
         if (!file.is_open())
             throw std::runtime_error{ "File not writable!" };
-        details::PrintHelper{ file }
+        save(file);
+    }
+
+    /**
+     * @brief Serialize everything to a stream, such as a buffer to be written later
+     */
+    void save(std::ostream& os) const
+    {
+        saveSections(os);
+        details::PrintHelper{ os }.printLn(hitObjects);
+    }
+
+    /**
+     * @brief Serialize everything but the hit objects, ending with the "[HitObjects]" line
+     * @details The hit objects can then be written one per line
+     */
+    void saveSections(std::ostream& os) const
+    {
+        details::PrintHelper{ os }
             .printLn("osu file format v14")
             .printLn("")
             .printLn(general)
@@ -2170,8 +2217,7 @@ struct OsuFile
             .printLn("")
             .printLn(events)
             .printLn("")
-            .printLn("[HitObjects]")
-            .printLn(hitObjects);
+            .printLn("[HitObjects]");
     }
 
     /**
@@ -2182,7 +2228,7 @@ struct OsuFile
     {
         constexpr auto suffix = ".osu";
         auto const saveFileName = std::string{ fileName } + suffix;
-        std::cout << "Map saved -> " << saveFileName << '\n';
+        Log(LogLevel::Info, "Map saved -> ", saveFileName);
         save(std::ofstream{ saveFileName });
     }
 
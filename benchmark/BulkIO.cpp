@@ -0,0 +1,130 @@
+/*****************************************************************//**
+ * \file   BulkIO.cpp
+ * \brief  Compare the read and write throughput of the bulk I/O backends on many copies of a map, with a cold and a warm page cache
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#include "BeatmapConvert/include/BulkIO.hpp"
+#include <chrono>
+#include <fstream>
+#include <iostream>
+#include <iterator>
+#ifndef _WIN32
+#include <fcntl.h>
+#include <unistd.h>
+#endif
+
+/**
+ * @brief Drop the pages of the files from the page cache, so the next read goes to the disk
+ * @return Whether it could be done
+ */
+static bool Evict(std::vector<std::filesystem::path> const& paths)
+{
+#ifdef POSIX_FADV_DONTNEED
+	for (auto const& path : paths)
+	{
+		auto const fd = open(path.c_str(), O_RDONLY);
+		if (fd == -1)
+			return false;
+		/*Only clean pages are dropped*/
+		(void)fdatasync(fd);
+		(void)posix_fadvise(fd, 0, 0, POSIX_FADV_DONTNEED);
+		close(fd);
+	}
+	return true;
+#else
+	(void)paths;
+	return false;
+#endif
+}
+
+/**
+ * @brief Seconds taken by `task`
+ */
+template<typename Task>
+static double Time(Task&& task)
+{
+	auto const start = std::chrono::steady_clock::now();
+	task();
+	return std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+}
+
+/**
+ * @brief Usage: Benchmark.BulkIO [map.osu] [copies] [folder]
+ * @details The copies, 2000 by default, are written to a new "BulkIOBenchmark" folder under the folder, the current one by default.
+ * Only that folder is removed at the end, and it must not exist before.
+ */
+int main(int argc, char const** argv)
+{
+	auto const path = argc > 1 ? argv[1] : "test/TestMapv11.osu";
+	auto const copies = argc > 2 ? std::stoul(argv[2]) : 2000ul;
+	auto const folder = std::filesystem::path{ argc > 3 ? argv[3] : "." } / "BulkIOBenchmark";
+
+	std::ifstream map{ path, std::ios::binary };
+	if (!map.is_open())
+	{
+		std::cerr << "Cannot read " << path << '\n';
+		return 1;
+	}
+	std::string const content{ std::istreambuf_iterator<char>{ map }, std::istreambuf_iterator<char>{} };
+
+	if (!std::filesystem::create_directories(folder))
+	{
+		std::cerr << folder << " already exists, remove it first\n";
+		return 1;
+	}
+	std::vector<Mania::BulkWrite> files;
+	std::vector<std::filesystem::path> paths;
+	for (unsigned long i = 0; i < copies; ++i)
+	{
+		paths.push_back(folder / (std::to_string(i) + ".osu"));
+		files.push_back({ paths.back(), content });
+	}
+	auto const mebibytes = static_cast<double>(content.size()) * copies / (1 << 20);
+	std::cout << copies << " copies of " << path << ", " << mebibytes << " MiB\n";
+
+	auto const readAll = [&paths](Mania::BulkIO& io)
+	{
+		size_t failed = 0;
+		io.read(paths, [&failed](Mania::BulkRead&& file) { failed += file.error ? 1 : 0; });
+		if (failed != 0)
+			std::cerr << failed << " files not read\n";
+	};
+
+	for (auto const backend : { Mania::IoBackend::Blocking, Mania::IoBackend::IoUring })
+	{
+		std::unique_ptr<Mania::BulkIO> io;
+		try
+		{
+			io = std::make_unique<Mania::BulkIO>(backend);
+		}
+		catch (std::system_error const& e)
+		{
+			std::cout << '\t' << backend << ": " << e.what() << '\n';
+			continue;
+		}
+
+		/*Best of a few rounds, each writing then reading cold then warm*/
+		double write{ 1e9 }, cold{ 1e9 }, warm{ 1e9 };
+		bool evicted = true;
+		for (int round = 0; round < 3; ++round)
+		{
+			write = std::min(write, Time([&] { (void)io->write(files); }));
+			evicted = Evict(paths) && evicted;
+			cold = std::min(cold, Time([&] { readAll(*io); }));
+			warm = std::min(warm, Time([&] { readAll(*io); }));
+		}
+
+		auto const print = [&](char const* name, double seconds)
+		{
+			std::cout << "\t\t" << name << ": " << seconds * 1000 << " ms, " << copies / seconds << " files/s, " << mebibytes / seconds << " MiB/s\n";
+		};
+		std::cout << '\t' << backend << ":\n";
+		print("write", write);
+		print(evicted ? "cold read" : "cold read (page cache not dropped)", cold);
+		print("warm read", warm);
+	}
+
+	std::filesystem::remove_all(folder);
+}
@@ -0,0 +1,63 @@
+/*****************************************************************//**
+ * \file   ConvertAllocations.cpp
+ * \brief  Count heap allocations of converting a beatmap to osu!mania
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#include "BeatmapConvert/include/BeatmapConvert.hpp"
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+static std::atomic<std::size_t> allocations{ 0 };
+
+void* operator new(std::size_t size)
+{
+	++allocations;
+	if (auto const ptr = std::malloc(size == 0 ? 1 : size))
+		return ptr;
+	throw std::bad_alloc{};
+}
+
+void operator delete(void* ptr) noexcept
+{
+	std::free(ptr);
+}
+
+void operator delete(void* ptr, std::size_t) noexcept
+{
+	std::free(ptr);
+}
+
+/**
+ * @brief Usage: Benchmark.ConvertAllocations [map.osu] [iterations]
+ */
+int main(int argc, char const** argv)
+{
+	auto const path = argc > 1 ? argv[1] : "test/TestMapv11.osu";
+	auto const iterations = argc > 2 ? std::stoi(argv[2]) : 50;
+
+	OsuFile const original{ std::ifstream{ path } };
+	std::size_t totalAllocations{}, convertedCount{};
+
+	auto const start = std::chrono::steady_clock::now();
+	for (int i = 0; i < iterations; ++i)
+	{
+		Mania::ManiaBeatmapConverter converter{ original };
+		converter.setSeed(i);
+
+		auto const before = allocations.load();
+		auto const converted = converter.convertBeatmap();
+		totalAllocations += allocations.load() - before;
+		convertedCount += converted.hitObjects.size();
+	}
+	auto const elapsed = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+
+	auto const originalCount = original.hitObjects.size() * iterations;
+	std::cout << path << ": " << original.hitObjects.size() << " objects -> " << convertedCount / iterations << " notes\n"
+		<< '\t' << static_cast<double>(totalAllocations) / originalCount << " allocations per original object\n"
+		<< '\t' << static_cast<double>(totalAllocations) / convertedCount << " allocations per converted note\n"
+		<< '\t' << elapsed / iterations << " ms per conversion\n";
+}
@@ -0,0 +1,60 @@
+/*****************************************************************//**
+ * \file   ConvertKeyCount.cpp
+ * \brief  Compare the conversion time of the generators compiled for a key count against the run time key count ones
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#include "BeatmapConvert/include/BeatmapConvert.hpp"
+#include <chrono>
+
+/**
+ * @brief Milliseconds per conversion of `original` to `keyCount` keys
+ */
+static double TimeConversion(OsuFile const& original, int keyCount, bool specialized, int iterations)
+{
+	double elapsed{};
+	for (int i = 0; i < iterations; ++i)
+	{
+		Mania::ManiaBeatmapConverter converter{ original };
+		converter.setSeed(i).setTargetColumn(keyCount, specialized);
+
+		auto const start = std::chrono::steady_clock::now();
+		auto const converted = converter.convertBeatmap();
+		elapsed += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+	return elapsed / iterations;
+}
+
+/**
+ * @brief Usage: Benchmark.ConvertKeyCount [map.osu] [iterations] [key counts...]
+ * @details Key counts default to 4 and 7
+ */
+int main(int argc, char const** argv)
+{
+	auto const path = argc > 1 ? argv[1] : "test/TestMapv11.osu";
+	auto const iterations = argc > 2 ? std::stoi(argv[2]) : 50;
+
+	std::vector<int> keyCounts;
+	for (int i = 3; i < argc; ++i)
+		keyCounts.push_back(std::stoi(argv[i]));
+	if (keyCounts.empty())
+		keyCounts = { 4, 7 };
+
+	OsuFile const original{ std::ifstream{ path } };
+	std::cout << path << ": " << original.hitObjects.size() << " objects\n";
+	for (auto const keyCount : keyCounts)
+	{
+		/*Warm up, then alternate so that both paths see the same cache and frequency state*/
+		TimeConversion(original, keyCount, true, 1);
+
+		double runtime{}, specialized{};
+		for (int round = 0; round < 5; ++round)
+		{
+			runtime += TimeConversion(original, keyCount, false, iterations);
+			specialized += TimeConversion(original, keyCount, true, iterations);
+		}
+		std::cout << '\t' << keyCount << "K: " << runtime / 5 << " ms run time key count, "
+			<< specialized / 5 << " ms specialized (" << runtime / specialized << "x)\n";
+	}
+}
@@ -0,0 +1,163 @@
+#pragma once
+#include <atomic>
+#include <memory>
+#include <thread>
+#include <chrono>
+#include <cstddef>
+
+/**
+ * @brief A bounded lock-free multi-producer multi-consumer queue (Dmitry Vyukov's array queue)
+ * @details Every cell carries a sequence number telling whether it is ready to be written or read,
+ * so producers and consumers only contend on one atomic position each.
+ * `push()` and `pop()` wait by backing off when the queue is full or empty, which is the backpressure between pipeline stages.
+ * @tparam T Default constructible and move assignable
+ */
+template<typename T>
+class BoundedQueue
+{
+public:
+	/**
+	 * @param capacity Rounded up to a power of 2, and at least 2
+	 */
+	explicit BoundedQueue(size_t capacity)
+	{
+		size_t size = 2;
+		while (size < capacity)
+			size *= 2;
+
+		cells = std::make_unique<Cell[]>(size);
+		mask = size - 1;
+		for (size_t i = 0; i < size; ++i)
+			cells[i].sequence.store(i, std::memory_order_relaxed);
+	}
+
+	BoundedQueue(BoundedQueue const&) = delete;
+	BoundedQueue& operator=(BoundedQueue const&) = delete;
+
+	/**
+	 * @brief Move `value` into the queue if it is not full
+	 */
+	bool tryPush(T& value)
+	{
+		auto position = enqueuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			auto& cell = cells[position & mask];
+			auto const sequence = cell.sequence.load(std::memory_order_acquire);
+			auto const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position);
+			if (difference == 0)
+			{
+				if (enqueuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					cell.value = std::move(value);
+					cell.sequence.store(position + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = enqueuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Move the oldest value out of the queue if it is not empty
+	 */
+	bool tryPop(T& value)
+	{
+		auto position = dequeuePosition.load(std::memory_order_relaxed);
+		while (true)
+		{
+			auto& cell = cells[position & mask];
+			auto const sequence = cell.sequence.load(std::memory_order_acquire);
+			auto const difference = static_cast<std::ptrdiff_t>(sequence) - static_cast<std::ptrdiff_t>(position + 1);
+			if (difference == 0)
+			{
+				if (dequeuePosition.compare_exchange_weak(position, position + 1, std::memory_order_relaxed))
+				{
+					value = std::move(cell.value);
+					cell.value = T{};
+					cell.sequence.store(position + mask + 1, std::memory_order_release);
+					return true;
+				}
+			}
+			else if (difference < 0)
+				return false;
+			else
+				position = dequeuePosition.load(std::memory_order_relaxed);
+		}
+	}
+
+	/**
+	 * @brief Wait until `value` fits in the queue
+	 */
+	void push(T value)
+	{
+		for (Backoff backoff; !tryPush(value); )
+			backoff();
+	}
+
+	/**
+	 * @brief Wait for a value
+	 * @return false if the queue is closed and empty
+	 */
+	bool pop(T& value)
+	{
+		for (Backoff backoff; !tryPop(value); backoff())
+		{
+			/*Every push finished before the close, so one more try drains the queue*/
+			if (closed.load(std::memory_order_acquire))
+				return tryPop(value);
+		}
+		return true;
+	}
+
+	/**
+	 * @brief No value will be pushed any more, `pop()` returns false once the queue is empty
+	 */
+	void close() { closed.store(true, std::memory_order_release); }
+
+	[[nodiscard]] size_t capacity() const { return mask + 1; }
+
+	/**
+	 * @brief Number of values in the queue, only a snapshot when other threads are using it
+	 */
+	[[nodiscard]] size_t size() const
+	{
+		auto const dequeued = dequeuePosition.load(std::memory_order_relaxed);
+		auto const enqueued = enqueuePosition.load(std::memory_order_relaxed);
+		return enqueued > dequeued ? enqueued - dequeued : 0;
+	}
+
+private:
+	struct Cell
+	{
+		std::atomic<size_t> sequence;
+		T value;
+	};
+
+	/**
+	 * @brief Spin briefly, then yield, then sleep, so a stage waiting on a slow neighbour doesn't burn a core
+	 */
+	struct Backoff
+	{
+		int count = 0;
+
+		void operator()()
+		{
+			if (++count < 64)
+				return;
+			if (count < 128)
+				std::this_thread::yield();
+			else
+				std::this_thread::sleep_for(std::chrono::microseconds{ 100 });
+		}
+	};
+
+	std::unique_ptr<Cell[]> cells;
+	size_t mask;
+	alignas(64) std::atomic<size_t> enqueuePosition{};
+	alignas(64) std::atomic<size_t> dequeuePosition{};
+	std::atomic<bool> closed{};
+};
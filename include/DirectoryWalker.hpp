@@ -0,0 +1,136 @@
+#pragma once
+#include <filesystem>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <vector>
+#include <atomic>
+#include <exception>
+#include <algorithm>
+
+/**
+ * @brief Walks a directory tree on several threads, each listing one directory at a time
+ * @details A subdirectory is handed to the other threads as soon as it is found, so a library of thousands of folders
+ * is listed in parallel, and every file is passed on while the walk goes on instead of after it.
+ * Like `std::filesystem::recursive_directory_iterator`, symbolic links to directories are not followed.
+ * Directories that cannot be listed are skipped.
+ */
+class DirectoryWalker
+{
+public:
+	/**
+	 * @param threads Number of threads listing directories, 0 for `std::thread::hardware_concurrency()` but at least 4,
+	 * as listing mostly waits for the disk
+	 */
+	explicit DirectoryWalker(unsigned threads = 0)
+		: threads{ threads != 0 ? threads : std::max(4u, std::thread::hardware_concurrency()) }
+	{
+	}
+
+	/**
+	 * @brief Call `onFile` with every file under `root`
+	 * @param onFile Called with a `std::filesystem::directory_entry const&`, from several threads at the same time
+	 * @throw std::filesystem::filesystem_error if `root` is not a directory, or the first exception thrown by `onFile`
+	 */
+	template<typename OnFile>
+	void walk(std::filesystem::path const& root, OnFile&& onFile)
+	{
+		if (!std::filesystem::is_directory(root))
+			throw std::filesystem::filesystem_error{ "Not a directory", root, std::make_error_code(std::errc::not_a_directory) };
+
+		State state;
+		state.pending.push_back(root);
+
+		std::vector<std::thread> workers;
+		workers.reserve(threads);
+		for (unsigned i = 0; i < threads; ++i)
+			workers.emplace_back([&] { work(state, onFile); });
+		for (auto& worker : workers)
+			worker.join();
+
+		directoryCount = state.listed;
+		if (state.error)
+			std::rethrow_exception(state.error);
+	}
+
+	[[nodiscard]] unsigned size() const { return threads; }
+
+	/**
+	 * @brief Number of directories listed by the last `walk()`
+	 */
+	[[nodiscard]] size_t getDirectoryCount() const { return directoryCount; }
+
+private:
+	struct State
+	{
+		std::mutex mutex;
+		std::condition_variable wakeUp;
+		std::vector<std::filesystem::path> pending;
+
+		/**
+		 * @brief Directories being listed, the walk is over when none is and none is pending
+		 */
+		unsigned listing = 0;
+
+		size_t listed = 0;
+		std::exception_ptr error;
+	};
+
+	unsigned threads;
+	size_t directoryCount = 0;
+
+	template<typename OnFile>
+	static void work(State& state, OnFile& onFile)
+	{
+		std::unique_lock lock{ state.mutex };
+		while (true)
+		{
+			state.wakeUp.wait(lock, [&state] { return !state.pending.empty() || state.listing == 0; });
+			if (state.pending.empty())
+				return;
+
+			auto const directory = std::move(state.pending.back());
+			state.pending.pop_back();
+			++state.listing;
+			lock.unlock();
+
+			try
+			{
+				list(state, directory, onFile);
+			}
+			catch (...)
+			{
+				std::lock_guard errorLock{ state.mutex };
+				if (!state.error)
+					state.error = std::current_exception();
+			}
+
+			lock.lock();
+			++state.listed;
+			if (--state.listing == 0 && state.pending.empty())
+				state.wakeUp.notify_all();
+		}
+	}
+
+	template<typename OnFile>
+	static void list(State& state, std::filesystem::path const& directory, OnFile& onFile)
+	{
+		std::error_code error;
+		std::filesystem::directory_iterator iter{ directory, std::filesystem::directory_options::skip_permission_denied, error };
+		for (; !error && iter != std::filesystem::directory_iterator{}; iter.increment(error))
+		{
+			auto const& entry = *iter;
+			if (entry.is_directory(error) && !entry.is_symlink(error))
+			{
+				{
+					std::lock_guard lock{ state.mutex };
+					state.pending.push_back(entry.path());
+				}
+				state.wakeUp.notify_one();
+			}
+			else if (entry.is_regular_file(error))
+				onFile(entry);
+			error.clear();
+		}
+	}
+};
@@ -14,7 +14,7 @@
 class JumpGenerator
 {
 public:
-	JumpGenerator(OsuFile& file) : osuFile{ file } {}
+	JumpGenerator(OsuFile& file, std::uint64_t seed = std::random_device{}()) : osuFile{ file }, random{ seed } {}
 	void generate(int count);
 
 	JumpGenerator& setDistance(int distance);
@@ -28,5 +28,7 @@ private:
 
 	std::variant<int, Range<int>> length;
 
+	RandomEngine random;
+
 	static Coord getNextNotePos(Coord note, float angle, int distance);
 };
@@ -0,0 +1,356 @@
+#pragma once
+#include "BoundedQueue.hpp"
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <ctime>
+#include <functional>
+#include <iomanip>
+#include <iostream>
+#include <memory>
+#include <mutex>
+#include <optional>
+#include <sstream>
+#include <string>
+#include <string_view>
+#include <thread>
+#include <vector>
+#include <algorithm>
+
+enum class LogLevel
+{
+	Debug,
+	Info,
+	Warning,
+	Error,
+
+	/**
+	 * @brief As a level, logs nothing
+	 */
+	Off
+};
+
+[[nodiscard]] inline char const* ToString(LogLevel level)
+{
+	constexpr char const* Names[]{ "debug", "info", "warning", "error", "off" };
+	return Names[static_cast<int>(level)];
+}
+
+/**
+ * @brief "debug", "info", "warning", "error" or "off"
+ */
+[[nodiscard]] inline std::optional<LogLevel> ParseLogLevel(std::string_view name)
+{
+	for (auto const level : { LogLevel::Debug, LogLevel::Info, LogLevel::Warning, LogLevel::Error, LogLevel::Off })
+	{
+		if (name == ToString(level))
+			return level;
+	}
+	return {};
+}
+
+struct LogRecord
+{
+	LogLevel level{};
+	std::chrono::system_clock::time_point time;
+
+	/**
+	 * @brief Order in which the records were logged, across all threads
+	 */
+	std::uint64_t sequence{};
+
+	/**
+	 * @brief Number of the thread that logged it, in the order threads first logged
+	 */
+	unsigned thread{};
+
+	std::string message;
+};
+
+/**
+ * @brief Messages logged from any thread, handed to a sink by a background thread
+ * @details Each thread logs into a lock-free buffer of its own, so logging waits neither for the output nor for other threads,
+ * unless its buffer is full. The background thread takes the records of every buffer a few times per second, or as soon as
+ * `flush()` is called, sorts what it took by `LogRecord::sequence` and calls the sink with each. The records of a thread are
+ * always written in order, those of different threads only when they are taken together.
+ * As the sink is only called from that thread, lines never interleave.
+ * Messages below the level are not even formatted by `Log()`.
+ */
+class Logger
+{
+public:
+	using Sink = std::function<void(LogRecord const&)>;
+
+	/**
+	 * @brief Records a thread can have waiting before logging waits for the background thread
+	 */
+	static constexpr size_t BufferCapacity = 1024;
+
+	/**
+	 * @brief Longest a record waits before it is written
+	 */
+	static constexpr std::chrono::milliseconds FlushInterval{ 50 };
+
+	/**
+	 * @brief The logger of the process, writing `TextSink()` at `LogLevel::Info` until changed
+	 */
+	static Logger& Get()
+	{
+		static Logger logger;
+		return logger;
+	}
+
+	/**
+	 * @brief Write what is left, then stop the background thread
+	 */
+	~Logger()
+	{
+		{
+			std::lock_guard lock{ mutex };
+			stopping = true;
+		}
+		wake.notify_one();
+		flusher.join();
+	}
+
+	Logger(Logger const&) = delete;
+	Logger& operator=(Logger const&) = delete;
+
+	void setLevel(LogLevel level)
+	{
+		this->level.store(level, std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] LogLevel getLevel() const
+	{
+		return level.load(std::memory_order_relaxed);
+	}
+
+	[[nodiscard]] bool isEnabled(LogLevel level) const
+	{
+		return level != LogLevel::Off && level >= getLevel();
+	}
+
+	/**
+	 * @brief Replace the sink, once the records logged before are written to the previous one
+	 */
+	void setSink(Sink sink)
+	{
+		flush();
+		std::lock_guard lock{ sinkMutex };
+		this->sink = std::move(sink);
+	}
+
+	/**
+	 * @brief Log a message without checking the level, a trailing line break is dropped as the sink ends each record
+	 */
+	void log(LogLevel level, std::string message)
+	{
+		if (!message.empty() && message.back() == '\n')
+			message.pop_back();
+
+		auto& buffer = getBuffer();
+		buffer.records.push(LogRecord{ level, std::chrono::system_clock::now(), sequence++, buffer.thread, std::move(message) });
+
+		/*Taken early rather than making the thread wait for room*/
+		if (buffer.records.size() > BufferCapacity / 2)
+			wake.notify_one();
+	}
+
+	/**
+	 * @brief Wait until every record logged before is written
+	 * @details Waits for a pass of the background thread that started after the call, which takes every record pushed before it.
+	 * Counting the records written instead could be fooled by a pass that took newer records of another thread.
+	 */
+	void flush()
+	{
+		std::unique_lock lock{ mutex };
+		auto const target = startedPasses + 1;
+		++flushing;
+		wake.notify_one();
+		flushed.wait(lock, [&] { return finishedPasses >= target; });
+		--flushing;
+	}
+
+	/**
+	 * @brief Debug and info messages to `out`, warnings and errors to `err`, one line each
+	 */
+	[[nodiscard]] static Sink TextSink(std::ostream& out = std::cout, std::ostream& err = std::cerr)
+	{
+		return [&out, &err](LogRecord const& record)
+		{
+			(record.level >= LogLevel::Warning ? err : out) << record.message << '\n';
+		};
+	}
+
+	/**
+	 * @brief One JSON object per line: {"time":"2026-10-18T09:30:00.125Z","level":"info","thread":1,"message":"..."}
+	 */
+	[[nodiscard]] static Sink JsonSink(std::ostream& os)
+	{
+		return [&os](LogRecord const& record)
+		{
+			auto const time = std::chrono::system_clock::to_time_t(record.time);
+			auto const milliseconds = std::chrono::duration_cast<std::chrono::milliseconds>(record.time.time_since_epoch()).count() % 1000;
+			/*Only called from the background thread*/
+			os << R"({"time":")" << std::put_time(std::gmtime(&time), "%FT%T") << '.' << std::setw(3) << std::setfill('0') << milliseconds
+				<< R"(Z","level":")" << ToString(record.level)
+				<< R"(","thread":)" << record.thread
+				<< R"(,"message":")";
+			for (auto const c : record.message)
+			{
+				switch (c)
+				{
+					case '"':	os << "\\\""; break;
+					case '\\':	os << "\\\\"; break;
+					case '\n':	os << "\\n"; break;
+					case '\r':	os << "\\r"; break;
+					case '\t':	os << "\\t"; break;
+					default:
+						if (static_cast<unsigned char>(c) < 0x20)
+							os << "\\u" << std::hex << std::setw(4) << std::setfill('0') << static_cast<int>(c) << std::dec;
+						else
+							os << c;
+				}
+			}
+			os << "\"}\n";
+		};
+	}
+
+private:
+	struct Buffer
+	{
+		explicit Buffer(unsigned thread) : thread{ thread } {}
+
+		unsigned const thread;
+		BoundedQueue<LogRecord> records{ BufferCapacity };
+
+		/**
+		 * @brief Set when its thread exits, it is dropped once emptied
+		 */
+		std::atomic<bool> orphaned{ false };
+	};
+
+	std::atomic<LogLevel> level{ LogLevel::Info };
+	std::atomic<std::uint64_t> sequence{};
+
+	std::mutex buffersMutex;
+	std::vector<std::shared_ptr<Buffer>> buffers;
+	unsigned threads{};
+
+	/**
+	 * @brief Guards the passes, `flushing` and `stopping`
+	 */
+	std::mutex mutex;
+	std::condition_variable wake;
+	std::condition_variable flushed;
+	/**
+	 * @brief Passes of the background thread over the buffers, numbered from 1
+	 */
+	std::uint64_t startedPasses{};
+	std::uint64_t finishedPasses{};
+	unsigned flushing{};
+	bool stopping = false;
+
+	std::mutex sinkMutex;
+	Sink sink = TextSink();
+
+	/**
+	 * @brief Last member, started once the others are ready
+	 */
+	std::thread flusher{ [this] { run(); } };
+
+	Logger() = default;
+
+	/**
+	 * @brief The buffer of the calling thread, made the first time it logs
+	 */
+	Buffer& getBuffer()
+	{
+		struct Owner
+		{
+			std::shared_ptr<Buffer> buffer;
+
+			~Owner()
+			{
+				if (buffer)
+					buffer->orphaned = true;
+			}
+		};
+		thread_local Owner owner;
+
+		if (!owner.buffer)
+		{
+			std::lock_guard lock{ buffersMutex };
+			owner.buffer = std::make_shared<Buffer>(++threads);
+			buffers.push_back(owner.buffer);
+		}
+		return *owner.buffer;
+	}
+
+	/**
+	 * @brief Take the records waiting in every buffer
+	 */
+	void take(std::vector<LogRecord>& records)
+	{
+		std::lock_guard lock{ buffersMutex };
+		for (auto iter = buffers.begin(); iter != buffers.end(); )
+		{
+			/*Read first, so an orphan is known to get no more records*/
+			auto const orphaned = (*iter)->orphaned.load();
+			for (LogRecord record; (*iter)->records.tryPop(record); )
+				records.push_back(std::move(record));
+			iter = orphaned ? buffers.erase(iter) : iter + 1;
+		}
+	}
+
+	void run()
+	{
+		std::vector<LogRecord> records;
+		while (true)
+		{
+			bool stop;
+			std::uint64_t pass;
+			{
+				std::unique_lock lock{ mutex };
+				wake.wait_for(lock, FlushInterval, [this] { return stopping || flushing != 0; });
+				stop = stopping;
+				pass = ++startedPasses;
+			}
+
+			records.clear();
+			take(records);
+			std::sort(records.begin(), records.end(), [](LogRecord const& left, LogRecord const& right) { return left.sequence < right.sequence; });
+			{
+				std::lock_guard lock{ sinkMutex };
+				for (auto const& record : records)
+					sink(record);
+			}
+
+			{
+				std::lock_guard lock{ mutex };
+				finishedPasses = pass;
+			}
+			flushed.notify_all();
+
+			if (stop && records.empty())
+				return;
+		}
+	}
+};
+
+/**
+ * @brief Log the arguments written one after another with `operator<<`, if `level` is enabled
+ */
+template<typename... Args>
+void Log(LogLevel level, Args&&... args)
+{
+	auto& logger = Logger::Get();
+	if (!logger.isEnabled(level))
+		return;
+
+	std::ostringstream os;
+	(os << ... << std::forward<Args>(args));
+	logger.log(level, os.str());
+}
@@ -1,4 +1,8 @@
+#pragma once
 #include <random>
+#include <algorithm>
+#include <cstdint>
+#include <limits>
 
 constexpr auto PI = 3.1415926535897L;
 
@@ -30,16 +34,105 @@ struct Range
 	}
 };
 
+/**
+ * @brief xoshiro256** generator, satisfies UniformRandomBitGenerator
+ * @details 32 bytes of state and a few instructions per number, so every conversion can own one.
+ * `jump()` advances the state by 2^128 numbers, which splits one seed into independent streams.
+ * @see https://prng.di.unimi.it/
+ */
+class Xoshiro256
+{
+	std::uint64_t state[4];
+
+	static constexpr std::uint64_t Rotl(std::uint64_t x, int k)
+	{
+		return (x << k) | (x >> (64 - k));
+	}
+public:
+	using result_type = std::uint64_t;
+
+	/**
+	 * @brief Expand a 64-bit seed into the full state with splitmix64, as recommended by the authors
+	 */
+	explicit Xoshiro256(std::uint64_t seed)
+	{
+		for (auto& s : state)
+		{
+			seed += 0x9e3779b97f4a7c15;
+			auto z = seed;
+			z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+			z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+			s = z ^ (z >> 31);
+		}
+	}
+
+	static constexpr result_type min() { return 0; }
+	static constexpr result_type max() { return std::numeric_limits<result_type>::max(); }
+
+	result_type operator()()
+	{
+		auto const result = Rotl(state[1] * 5, 7) * 9;
+		auto const t = state[1] << 17;
+
+		state[2] ^= state[0];
+		state[3] ^= state[1];
+		state[1] ^= state[2];
+		state[0] ^= state[3];
+		state[2] ^= t;
+		state[3] = Rotl(state[3], 45);
+		return result;
+	}
+
+	/**
+	 * @brief Equivalent to 2^128 calls to operator()
+	 */
+	void jump()
+	{
+		constexpr std::uint64_t Jump[]{ 0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c };
+
+		std::uint64_t s[4]{};
+		for (auto const jump : Jump)
+		{
+			for (int bit = 0; bit < 64; ++bit)
+			{
+				if (jump & (std::uint64_t{ 1 } << bit))
+				{
+					for (int i = 0; i < 4; ++i)
+						s[i] ^= state[i];
+				}
+				(*this)();
+			}
+		}
+		std::copy(std::begin(s), std::end(s), std::begin(state));
+	}
+};
+
+/**
+ * @brief A source of random numbers
+ * @details Each user (a beatmap conversion, a jump generator) owns its engine, so parallel conversions
+ * don't share state and the same seed always gives the same result.
+ */
 class RandomEngine
 {
-	inline static std::mt19937 eng{ std::random_device{}() };
+	Xoshiro256 eng;
 public:
+	explicit RandomEngine(std::uint64_t seed = std::random_device{}()) : eng{ seed } {}
+
+	/**
+	 * @brief Return an engine with an independent stream, then jump this engine past it
+	 */
+	[[nodiscard]] RandomEngine split()
+	{
+		auto copy = *this;
+		eng.jump();
+		return copy;
+	}
 
 	/**
 	 * @brief Return a random angle in degree
 	 */
 	template<typename Float = float>
-	static auto getAngleDegree(Float min = 0.0, Float max = 360.0)
+	auto getAngleDegree(Float min = 0.0, Float max = 360.0)
 	{
 		return std::uniform_real_distribution<Float>{min, max}(eng);
 	}
@@ -48,7 +141,7 @@ public:
 	 * @brief Return a random angle in rad
 	 */
 	template<typename Float = float>
-	static auto getAngleRad(Float min = 0.0, Float max = 2 * PI)
+	auto getAngleRad(Float min = 0.0, Float max = 2 * PI)
 	{
 		return getAngleDegree(RadToDegree(min), RadToDegree(max));
 	}
@@ -57,7 +150,7 @@ public:
 	 * @brief  Return a random integer
 	 */
 	template<typename T = int>
-	static auto getRand(T min, T max)
+	auto getRand(T min, T max)
 	{
 		if constexpr (std::is_integral_v<T>)
 			return std::uniform_int_distribution<T>{min, max}(eng);
@@ -66,13 +159,13 @@ public:
 	}
 
 	template<typename T = float, typename = std::enable_if_t<std::is_floating_point_v<T>>>
-	static auto getRand()
+	auto getRand()
 	{
 		return getRand(0.0, 1.0);
 	}
 
 	template<typename T = int>
-	static auto getRand(Range<T> range)
+	auto getRand(Range<T> range)
 	{
 		return std::uniform_int_distribution<T>{range.min, range.max}(eng);
 	}
@@ -0,0 +1,139 @@
+#pragma once
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <deque>
+#include <vector>
+#include <memory>
+#include <atomic>
+#include <type_traits>
+#include <algorithm>
+
+/**
+ * @brief A fixed number of worker threads, each with its own job queue, stealing from the others when it runs out
+ * @details Jobs are handed out to the queues in turn. A worker takes the oldest job of its own queue first,
+ * then the oldest job of the other queues, so jobs submitted in order of priority start roughly in that order.
+ * The destructor runs every submitted job before joining the workers.
+ */
+class ThreadPool
+{
+public:
+	/**
+	 * @param threads Number of workers, 0 for `std::thread::hardware_concurrency()`
+	 */
+	explicit ThreadPool(unsigned threads = 0)
+	{
+		auto const count = threads != 0 ? threads : std::max(1u, std::thread::hardware_concurrency());
+		queues.reserve(count);
+		for (unsigned i = 0; i < count; ++i)
+			queues.push_back(std::make_unique<Queue>());
+
+		workers.reserve(count);
+		for (unsigned i = 0; i < count; ++i)
+			workers.emplace_back([this, i] { work(i); });
+	}
+
+	ThreadPool(ThreadPool const&) = delete;
+	ThreadPool& operator=(ThreadPool const&) = delete;
+
+	~ThreadPool()
+	{
+		{
+			std::lock_guard lock{ sleepMutex };
+			stopping = true;
+		}
+		wakeUp.notify_all();
+		for (auto& worker : workers)
+			worker.join();
+	}
+
+	/**
+	 * @brief Queue `job` to run on one of the workers
+	 * @return The result of `job`, or the exception it throws
+	 */
+	template<typename Job>
+	[[nodiscard]] auto submit(Job&& job)
+	{
+		std::packaged_task<std::invoke_result_t<std::decay_t<Job>>()> task{ std::forward<Job>(job) };
+		auto result = task.get_future();
+
+		auto& queue = *queues[nextQueue++ % queues.size()];
+		{
+			/*Counted before it can be taken, and visible by the time a sleeping worker sees the count*/
+			std::lock_guard sleepLock{ sleepMutex };
+			++queued;
+			std::lock_guard lock{ queue.mutex };
+			queue.jobs.emplace_back([task = std::move(task)]() mutable { task(); });
+		}
+		wakeUp.notify_one();
+		return result;
+	}
+
+	[[nodiscard]] unsigned size() const { return static_cast<unsigned>(workers.size()); }
+
+	/**
+	 * @brief Number of jobs a worker took from the queue of another worker
+	 */
+	[[nodiscard]] size_t getStealCount() const { return steals; }
+
+private:
+	using Job = std::packaged_task<void()>;
+
+	struct Queue
+	{
+		std::mutex mutex;
+		std::deque<Job> jobs;
+	};
+
+	std::vector<std::unique_ptr<Queue>> queues;
+	std::vector<std::thread> workers;
+	std::atomic<size_t> nextQueue{};
+	std::atomic<size_t> steals{};
+
+	/**
+	 * @brief Jobs submitted but not taken yet, increased with `sleepMutex` held before the job is queued, so no wake up is lost
+	 * @note `submit()` locks a queue while holding `sleepMutex`, so the other way round would deadlock
+	 */
+	std::atomic<size_t> queued{};
+	std::mutex sleepMutex;
+	std::condition_variable wakeUp;
+	bool stopping = false;
+
+	bool tryPop(size_t index, Job& job)
+	{
+		auto& queue = *queues[index];
+		std::lock_guard lock{ queue.mutex };
+		if (queue.jobs.empty())
+			return false;
+		job = std::move(queue.jobs.front());
+		queue.jobs.pop_front();
+		--queued;
+		return true;
+	}
+
+	void work(size_t index)
+	{
+		while (true)
+		{
+			Job job;
+			auto found = tryPop(index, job);
+			for (size_t i = 1; !found && i < queues.size(); ++i)
+			{
+				if ((found = tryPop((index + i) % queues.size(), job)))
+					++steals;
+			}
+
+			if (found)
+			{
+				job();
+				continue;
+			}
+
+			std::unique_lock lock{ sleepMutex };
+			wakeUp.wait(lock, [this] { return stopping || queued != 0; });
+			if (stopping && queued == 0)
+				return;
+		}
+	}
+};
@@ -4,9 +4,64 @@
 #include <filesystem>
 #include <future>
 #include "BeatmapConvert/include/BeatmapConvert.hpp"
+#include "BeatmapConvert/include/Pipeline.hpp"
+#include "BeatmapConvert/include/Manifest.hpp"
+#include "BeatmapConvert/include/ConversionCache.hpp"
+#include "BeatmapConvert/include/Watch.hpp"
+#include "BeatmapConvert/include/Daemon.hpp"
+#include "BeatmapConvert/include/Admission.hpp"
+#include <csignal>
+#include "DirectoryWalker.hpp"
+#include "Logger.hpp"
+#include "BeatmapAnalyze/include/JumpAnalyzer.hpp"
+#include "BeatmapAnalyze/include/Lint.hpp"
 
+/**
+ * @brief Print osu!standard maps under `root` that have at least `minJumpPercent` 1-2 jumps at `minBPM` or faster
+ * @details Usage: Main --analyze <directory> [minJumpPercent] [minBPM]
+ */
+static void AnalyzeJumps(std::filesystem::path const& root, float minJumpPercent, float minBPM)
+{
+	auto const entries = Analyze::AnalyzeLibrary(root, minBPM, [minJumpPercent](Analyze::LibraryEntry const& entry)
+	{
+		return entry.jumpPercentAtMinBPM * 100.f >= minJumpPercent;
+	});
 
+	for (auto const& entry : entries)
+		std::cout << entry.path.string() << "\n\t" << entry.jumpPercentAtMinBPM * 100.f << "% jumps >= " << minBPM << " BPM, " << entry.summary << '\n';
+}
 
+/**
+ * @brief Print the lint issues of every osu!mania map under `root`
+ * @details Usage: Main --lint <directory>
+ */
+static void LintLibrary(std::filesystem::path const& root)
+{
+	int mapCount{}, issueCount{};
+	for (auto const& entry : std::filesystem::recursive_directory_iterator{ root })
+	{
+		if (!entry.is_regular_file() || entry.path().extension() != ".osu")
+			continue;
+		try
+		{
+			OsuFile const beatmap{ std::ifstream{ entry.path() } };
+			if (beatmap.general.mode != Mode::Mania)
+				continue;
+
+			++mapCount;
+			if (auto const report = Analyze::Lint(beatmap); !report.empty())
+			{
+				issueCount += static_cast<int>(report.issues.size());
+				std::cout << entry.path().string() << "\n\t" << report;
+			}
+		}
+		catch (std::exception const& e)
+		{
+			std::cerr << "Cannot parse " << entry.path().string() << ": " << e.what() << '\n';
+		}
+	}
+	std::cout << mapCount << " maps, " << issueCount << " issues\n";
+}
 
 int main(int argc, char const** argv)
 {
@@ -16,41 +71,218 @@ int main(int argc, char const** argv)
 	//	argv[1] = (char*)malloc(sizeof arg);
 	//	strcpy((char*)argv[1], arg);
 	//#endif
-	if(argc > 1)
+
+	/*Main [--log-level debug|info|warning|error|off] [--log-json <file>] ..., before any other argument.
+	The log file is static so that it outlives the logger, which writes to it until the end*/
+	static std::ofstream logFile;
+	while (argc > 2)
+	{
+		if (std::string_view{ argv[1] } == "--log-level")
+		{
+			auto const level = ParseLogLevel(argv[2]);
+			if (!level)
+			{
+				std::cerr << "Unknown log level: " << argv[2] << '\n';
+				return 1;
+			}
+			Logger::Get().setLevel(*level);
+		}
+		else if (std::string_view{ argv[1] } == "--log-json")
+		{
+			logFile.open(argv[2]);
+			if (!logFile.is_open())
+			{
+				std::cerr << "Cannot write the log to " << argv[2] << '\n';
+				return 1;
+			}
+			Logger::Get().setSink(Logger::JsonSink(logFile));
+		}
+		else
+			break;
+		argv[2] = argv[0];
+		argv += 2;
+		argc -= 2;
+	}
+
+	if (argc > 2 && std::string_view{ argv[1] } == "--analyze")
+	{
+		AnalyzeJumps(argv[2], argc > 3 ? std::stof(argv[3]) : 0.f, argc > 4 ? std::stof(argv[4]) : 0.f);
+		return 0;
+	}
+
+	if (argc > 2 && std::string_view{ argv[1] } == "--lint")
+	{
+		LintLibrary(argv[2]);
+		return 0;
+	}
+
+	/*Main --client <socket> convert|analyze <files...> [seed=<seed>] [keys=<keyCount>], or Main --client <socket> stats*/
+	if (argc > 3 && std::string_view{ argv[1] } == "--client")
+	{
+		std::string parameters;
+		std::vector<std::string_view> files;
+		for (int i = 4; i < argc; ++i)
+		{
+			if (std::string_view{ argv[i] }.find('=') != std::string_view::npos)
+				(parameters += '\t') += argv[i];
+			else
+				files.push_back(argv[i]);
+		}
+
+		std::vector<std::string> requests;
+		for (auto const file : files)
+			requests.push_back(std::string{ argv[3] } + '\t' + std::string{ file } + parameters);
+		if (files.empty())
+			requests.push_back(argv[3] + parameters);
+		return Mania::RunDaemonClient(argv[2], requests, std::cout) == 0 ? 0 : 1;
+	}
+
+	/*Main [-j <threads>] [--seed <seed>] [--cache <directory>] [--cache-size <MiB>] [--memory <MiB>] [files...], the same seed always gives the same conversion*/
+	std::optional<std::uint64_t> seed;
+	unsigned threads = 0;
+	std::optional<std::filesystem::path> cacheDirectory;
+	std::uintmax_t cacheBytes = Mania::ConversionCache::DefaultMaxBytes;
+	std::optional<Mania::MemoryBudget> budget;
+	int firstFile = 1;
+	while (argc > firstFile + 1)
+	{
+		if (std::string_view{ argv[firstFile] } == "--seed")
+			seed = std::stoull(argv[firstFile + 1]);
+		else if (std::string_view{ argv[firstFile] } == "-j")
+			threads = static_cast<unsigned>(std::stoul(argv[firstFile + 1]));
+		else if (std::string_view{ argv[firstFile] } == "--cache")
+			cacheDirectory = argv[firstFile + 1];
+		else if (std::string_view{ argv[firstFile] } == "--cache-size")
+			cacheBytes = std::stoull(argv[firstFile + 1]) << 20;
+		else if (std::string_view{ argv[firstFile] } == "--memory")
+			budget.emplace(std::stoull(argv[firstFile + 1]) << 20);
+		else
+			break;
+		firstFile += 2;
+	}
+
+	std::optional<Mania::ConversionCache> cache;
+	if (cacheDirectory)
+		cache.emplace(*cacheDirectory, cacheBytes);
+	auto const cachePointer = cache ? &*cache : nullptr;
+	auto const budgetPointer = budget ? &*budget : nullptr;
+
+	/*Main [options] --pipeline <directory> [readers] [parsers] [converters] [writers] [auto|io_uring|blocking], converts in stages and prints how busy each one was*/
+	if (argc > firstFile + 1 && std::string_view{ argv[firstFile] } == "--pipeline")
+	{
+		Mania::PipelineOptions options;
+		options.seed = seed;
+		if (threads != 0)
+			options.converters = threads;
+		std::array const stageThreads{ &options.readers, &options.parsers, &options.converters, &options.writers };
+		for (int i = firstFile + 2, stage = 0; i < argc; ++i)
+		{
+			if (auto const backend = Mania::ParseIoBackend(argv[i]))
+				options.bulkIO = backend;
+			else if (stage < static_cast<int>(stageThreads.size()))
+				*stageThreads[stage++] = static_cast<unsigned>(std::stoul(argv[i]));
+		}
+
+		std::mutex mutex;
+		std::vector<std::filesystem::directory_entry> entries;
+		DirectoryWalker{}.walk(argv[firstFile + 1], [&](std::filesystem::directory_entry const& entry)
+		{
+			if (!Mania::ShouldConvert(entry))
+				return;
+			std::lock_guard lock{ mutex };
+			entries.push_back(entry);
+		});
+		auto const stats = Mania::ConvertPipeline(std::move(entries), options);
+		Logger::Get().flush();
+		std::cout << "Pipeline: " << stats;
+		return 0;
+	}
+
+	/*Main [options] --stream <files...>, converts while reading each map, without loading it whole*/
+	if (argc > firstFile + 1 && std::string_view{ argv[firstFile] } == "--stream")
+	{
+		for (int i = firstFile + 1; i < argc; ++i)
+		{
+			try
+			{
+				Log(LogLevel::Info, "Map saved -> ", Mania::StreamConvert(std::filesystem::path{ argv[i] }, seed).string());
+			}
+			catch (std::exception const& e)
+			{
+				Log(LogLevel::Error, "Cannot convert ", argv[i], ": ", e.what());
+			}
+		}
+		return 0;
+	}
+
+	/*Main [options] --daemon <socket> [parsedMaps], answers requests until Ctrl+C*/
+	if (argc > firstFile + 1 && std::string_view{ argv[firstFile] } == "--daemon")
+	{
+		Mania::DaemonOptions options;
+		options.threads = threads;
+		if (argc > firstFile + 2)
+			options.parsedMaps = std::stoul(argv[firstFile + 2]);
+		Mania::Daemon daemon{ argv[firstFile + 1], options };
+
+		static Mania::Daemon* serving = nullptr;
+		serving = &daemon;
+		std::signal(SIGINT, [](int) { serving->stop(); });
+		std::signal(SIGTERM, [](int) { serving->stop(); });
+		daemon.run();
+		return 0;
+	}
+
+	/*Main [options] --watch <directory>, converts maps as they are written until Ctrl+C*/
+	if (argc > firstFile + 1 && std::string_view{ argv[firstFile] } == "--watch")
+	{
+		Mania::WatchOptions options;
+		options.seed = seed;
+		options.threads = threads;
+		options.cache = cachePointer;
+		Mania::LibraryWatcher watcher{ argv[firstFile + 1], std::move(options) };
+
+		/*stop() only writes to a file descriptor, which is safe in a signal handler*/
+		static Mania::LibraryWatcher* watching = nullptr;
+		watching = &watcher;
+		std::signal(SIGINT, [](int) { watching->stop(); });
+		watcher.run();
+
+		auto const stats = watcher.getStats();
+		Logger::Get().flush();
+		std::cout << stats.converted << " converted, " << stats.failed << " failed, " << stats.ignored << " ignored\n";
+		if (cache)
+			std::cout << "Cache: " << cache->getStats() << '\n';
+		return 0;
+	}
+
+	if(argc > firstFile)
 	{
 		/*convert the specified files*/
-		auto const numFileToConvert = argc - 1;
-		std::vector<std::future<void>> threads;
-		threads.reserve(numFileToConvert);
-		for(auto i = 0; i < numFileToConvert; ++i)
-		{
-			threads.emplace_back(
-				std::async(
-					std::launch::async,
-					[file = argv[i + 1]]()
-					{
-						if(!std::filesystem::directory_entry{std::filesystem::path{file}}.exists())
-						{
-							std::cerr << "File: " << file << " does not exist!\n";
-							return;
-						}
-						try{
-							/*OsuFile map{ std::ifstream{file} };
-							Mania::ManiaBeatmapConverter(map).setTargetColumn(4).convertBeatmap().save();*/
-							Mania::ConvertImpl(std::filesystem::directory_entry{ std::filesystem::path{file} }).get();
-						}
-						catch(...)
-						{
-							std::cerr << "Cannot convert " << file << '\n';
-						}
-					}
-				)
-			);
-		}
-		
-		for (auto&& thread : threads)
-			thread.get();
+		std::vector<std::filesystem::directory_entry> entries;
+		for (auto i = firstFile; i < argc; ++i)
+		{
+			std::filesystem::directory_entry entry{ std::filesystem::path{ argv[i] } };
+			if (!entry.exists())
+			{
+				Log(LogLevel::Error, "File: ", argv[i], " does not exist!");
+				continue;
+			}
+			entries.push_back(std::move(entry));
+		}
+		Mania::ConvertFiles(std::move(entries), seed, threads, cachePointer, budgetPointer);
 	}
 	else
-		Mania::ConvertAll("."); //recursively convert all files
+	{
+		/*recursively convert all files that changed since the last run*/
+		auto const stats = Mania::ConvertIncremental(".", seed, threads, cachePointer, budgetPointer);
+		Logger::Get().flush();
+		std::cout << stats.converted << " converted, " << stats.skipped << " unchanged, "
+			<< stats.removed << " removed, " << stats.failed << " failed\n";
+	}
+
+	Logger::Get().flush();
+	if (cache)
+		std::cout << "Cache: " << cache->getStats() << '\n';
+	if (budget)
+		std::cout << "Memory: " << budget->getStats() << '\n';
 }
\ No newline at end of file
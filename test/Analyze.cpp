@@ -0,0 +1,250 @@
+/*****************************************************************//**
+ * \file   Analyze.cpp
+ * \brief  Test cases for beatmap analyzers
+ *
+ * \author peterwhli
+ * \date   October 2026
+ *********************************************************************/
+#include "BeatmapAnalyze/include/JumpAnalyzer.hpp"
+#include <gtest/gtest.h>
+
+static auto MakeTimingPoint(int time, float beatLength)
+{
+	TimingPoint t;
+	t.time = time;
+	t.beatLength = beatLength;
+	t.meter = 4;
+	t.uninherited = true;
+	return std::vector{ t };
+}
+
+static void AddCircle(std::vector<std::unique_ptr<HitObject>>& objects, int x, int y, int time)
+{
+	objects.emplace_back(std::make_unique<Circle>(x, y, time, HitObject::HitSound::Normal, HitObject::HitSample{}));
+}
+
+TEST(JumpAnalyzer, Jumps)
+{
+	/*200 BPM, 1/2 spacing of 150ms, 200 osu!pixels apart*/
+	std::vector<std::unique_ptr<HitObject>> objects;
+	for (int i = 0; i < 8; ++i)
+		AddCircle(objects, i % 2 == 0 ? 100 : 300, 192, 1000 + i * 150);
+
+	auto const analysis = Analyze::AnalyzeJumps(objects, MakeTimingPoint(1000, 300));
+	ASSERT_EQ(analysis.pairs.size(), 7);
+	for (size_t i = 0; i < analysis.pairs.size(); ++i)
+	{
+		EXPECT_EQ(analysis.pairs.type[i], Analyze::PairType::Jump);
+		EXPECT_FLOAT_EQ(analysis.pairs.distance[i], 200.f);
+		EXPECT_FLOAT_EQ(analysis.pairs.timeDelta[i], 150.f);
+	}
+	EXPECT_FLOAT_EQ(analysis.pairs.angle[0], 0.f);
+	EXPECT_FLOAT_EQ(analysis.pairs.angle[1], 180.f);
+	EXPECT_FLOAT_EQ(analysis.getPercentOf(Analyze::PairType::Jump, 200.f), 1.f);
+	EXPECT_FLOAT_EQ(analysis.getPercentOf(Analyze::PairType::Jump, 201.f), 0.f);
+	EXPECT_FLOAT_EQ(analysis.summary.maxJumpBPM, 200.f);
+}
+
+TEST(JumpAnalyzer, StreamsAndBursts)
+{
+	std::vector<std::unique_ptr<HitObject>> objects;
+	/*A 12 note stream, at 1/4 of a 400ms beat*/
+	for (int i = 0; i < 12; ++i)
+		AddCircle(objects, 100 + i * 10, 192, i * 100);
+	/*A 4 note burst after a break*/
+	for (int i = 0; i < 4; ++i)
+		AddCircle(objects, 100 + i * 10, 192, 5000 + i * 100);
+	/*A stack*/
+	AddCircle(objects, 300, 300, 7000);
+	AddCircle(objects, 300, 300, 7200);
+
+	auto const analysis = Analyze::AnalyzeJumps(objects, MakeTimingPoint(0, 400));
+	auto const& counts = analysis.summary.pairCounts;
+	EXPECT_EQ(counts[static_cast<size_t>(Analyze::PairType::Stream)], 11);
+	EXPECT_EQ(counts[static_cast<size_t>(Analyze::PairType::Burst)], 3);
+	EXPECT_EQ(counts[static_cast<size_t>(Analyze::PairType::Stack)], 1);
+	EXPECT_EQ(counts[static_cast<size_t>(Analyze::PairType::Jump)], 0);
+	EXPECT_EQ(analysis.pairs.type.back(), Analyze::PairType::Stack);
+}
+
+TEST(JumpAnalyzer, Sections)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	auto const analysis = Analyze::AnalyzeJumps(f);
+	ASSERT_FALSE(analysis.sections.empty());
+
+	int total{};
+	for (auto const& section : analysis.sections)
+	{
+		for (auto count : section.types)
+			total += count;
+	}
+	EXPECT_EQ(total, static_cast<int>(f.getCount() - 1));
+}
+
+#include "BeatmapAnalyze/include/Density.hpp"
+TEST(Density, RecentNoteTimes)
+{
+	Analyze::RecentNoteTimes<3> times;
+	times.push(0);
+	times.push(100);
+	EXPECT_EQ(times.size(), 2);
+	EXPECT_DOUBLE_EQ(times.getDensity(), 50.0);
+
+	times.push(200);
+	times.push(600);
+	EXPECT_EQ(times.size(), 3);
+	EXPECT_EQ(times.front(), 100);
+	EXPECT_EQ(times.back(), 600);
+	EXPECT_DOUBLE_EQ(times.getDensity(), 500 / 3.0);
+}
+
+TEST(Density, NpsCurve)
+{
+	/*3 circles and a hold spanning [500, 2500]*/
+	std::vector<int> const starts{ 0, 100, 200, 500 };
+	std::vector<int> const ends{ 0, 100, 200, 2500 };
+
+	auto const curve = Analyze::ComputeNpsCurve(starts, ends, 0, 2500, 1000, 500);
+	ASSERT_EQ(curve.size(), 6);
+	EXPECT_FLOAT_EQ(curve[0], 4.f);  //[0, 1000)
+	EXPECT_FLOAT_EQ(curve[1], 1.f);  //[500, 1500), only the hold
+	EXPECT_FLOAT_EQ(curve[5], 1.f);  //[2500, 3500), the hold ends here
+}
+
+TEST(Density, Analyze)
+{
+	OsuFile f{ std::ifstream{"TestMania.osu"} };
+	auto const analysis = Analyze::AnalyzeDensity(f);
+	ASSERT_FALSE(analysis.curve.empty());
+	EXPECT_FLOAT_EQ(analysis.getPercentile(100), analysis.peak);
+	EXPECT_LE(analysis.getPercentile(50), analysis.peak);
+	EXPECT_GT(analysis.drainNormalized, 0.f);
+}
+
+#include "BeatmapAnalyze/include/Snap.hpp"
+TEST(Snap, Classify)
+{
+	/*Beat length of 480ms at 1000ms, then 300ms from 5800ms*/
+	auto timingPoints = MakeTimingPoint(1000, 480);
+	timingPoints.push_back(MakeTimingPoint(5800, 300).front());
+
+	std::vector<std::unique_ptr<HitObject>> objects;
+	AddCircle(objects, 0, 0, 1000);        //1/1
+	AddCircle(objects, 0, 0, 1240);        //1/2
+	AddCircle(objects, 0, 0, 1560);        //1/6
+	AddCircle(objects, 0, 0, 1640);        //1/3
+	AddCircle(objects, 0, 0, 1840);        //1/4
+	AddCircle(objects, 0, 0, 2020);        //1/8
+	AddCircle(objects, 0, 0, 2031);        //unsnapped, 9ms before a 1/6 tick
+	AddCircle(objects, 0, 0, 5875);        //1/4 of the second timing point
+
+	auto const report = Analyze::ClassifySnaps(objects, timingPoints);
+	std::vector expected{
+		Analyze::SnapDivisor::Whole,
+		Analyze::SnapDivisor::Half,
+		Analyze::SnapDivisor::Sixth,
+		Analyze::SnapDivisor::Third,
+		Analyze::SnapDivisor::Quarter,
+		Analyze::SnapDivisor::Eighth,
+		Analyze::SnapDivisor::Unsnapped,
+		Analyze::SnapDivisor::Quarter
+	};
+	EXPECT_EQ(report.snaps, expected);
+
+	ASSERT_EQ(report.unsnapped.size(), 1);
+	EXPECT_EQ(report.unsnapped.front().index, 6);
+	EXPECT_NEAR(report.unsnapped.front().offsetError, -9.f, 0.01f);
+
+	/*Out of order, as in a converted map, each object keeps its snap*/
+	std::swap(objects[1], objects[7]);
+	std::swap(expected[1], expected[7]);
+	auto const unsorted = Analyze::ClassifySnaps(objects, timingPoints);
+	EXPECT_EQ(unsorted.snaps, expected);
+	ASSERT_EQ(unsorted.unsnapped.size(), 1);
+	EXPECT_EQ(unsorted.unsnapped.front().index, 6);
+}
+
+#include "BeatmapAnalyze/include/ManiaAnalyzer.hpp"
+TEST(ManiaAnalyzer, Patterns)
+{
+	std::vector<Analyze::ColumnNotes> columns(4);
+	/*A trill between column 0 and 1: 0, 100, 200, 300, 400, 500*/
+	for (int i = 0; i < 6; ++i)
+		columns[i % 2].add(i * 100, i * 100);
+	/*A roll 0 -> 1 -> 2 -> 3 after a break*/
+	for (int i = 0; i < 4; ++i)
+		columns[i].add(2000 + i * 100, 2000 + i * 100);
+	/*A 3-note chord with a hold in column 3*/
+	columns[0].add(3000, 3000);
+	columns[2].add(3000, 3000);
+	columns[3].add(3000, 4000);
+
+	auto const analysis = Analyze::AnalyzeMania(columns);
+	EXPECT_EQ(analysis.noteCount, 13);
+	EXPECT_EQ(analysis.holdCount, 1);
+	EXPECT_EQ(analysis.columnCounts, (std::vector{ 5, 4, 2, 2 }));
+	EXPECT_EQ(analysis.jackCounts, (std::vector{ 2, 2, 0, 0 }));
+	EXPECT_EQ(analysis.minJackGaps[0], 200);
+	EXPECT_EQ(analysis.chordSizes[1], 10);
+	EXPECT_EQ(analysis.chordSizes[3], 1);
+	EXPECT_EQ(analysis.trillCount, 1);
+	EXPECT_EQ(analysis.trillNotes, 6);
+	EXPECT_EQ(analysis.rollCount, 1);
+	EXPECT_EQ(analysis.rollNotes, 4);
+	EXPECT_EQ(analysis.leftHandNotes, 9);
+	EXPECT_EQ(analysis.rightHandNotes, 4);
+	EXPECT_FLOAT_EQ(analysis.holdCoverage, 1000 / 4000.f);
+}
+
+TEST(ManiaAnalyzer, Analyze)
+{
+	OsuFile f{ std::ifstream{"TestMania.osu"} };
+	auto const analysis = Analyze::AnalyzeMania(f);
+	EXPECT_EQ(analysis.keyCount, static_cast<int>(f.difficulty.circleSize));
+	EXPECT_EQ(analysis.noteCount, static_cast<int>(f.getCount()));
+	for (int i = 0; i < analysis.keyCount; ++i)
+		EXPECT_FLOAT_EQ(analysis.getPercentOfColumn(i), f.getPercentOfHitObjectInColumn(i));
+}
+
+#include "BeatmapAnalyze/include/Lint.hpp"
+TEST(Lint, Checks)
+{
+	/*4K, beat length of 320ms, so holds shorter than 10ms are too short*/
+	OsuFile map;
+	map.general.mode = Mode::Mania;
+	map.difficulty.circleSize = 4;
+	map.timingPoints = MakeTimingPoint(0, 320);
+	map.events += Break{ 2000, 3000 };
+
+	auto const addHold = [&map](int column, int time, int endTime)
+	{
+		map.hitObjects.emplace_back(std::make_unique<Hold>(HitObject::ColumnToX(column, 4), 192, time, HitObject::HitSound::Normal, endTime, HitObject::HitSample{}));
+	};
+	AddCircle(map.hitObjects, HitObject::ColumnToX(0, 4), 192, 0);
+	addHold(1, 100, 500);
+	AddCircle(map.hitObjects, HitObject::ColumnToX(1, 4), 192, 300);    //overlaps the hold
+	addHold(2, 400, 405);                                               //too short
+	addHold(3, 600, 550);                                               //reversed
+	AddCircle(map.hitObjects, HitObject::ColumnToX(0, 4), 192, 2500);   //in the break
+	AddCircle(map.hitObjects, HitObject::ColumnToX(2, 4), 192, 1000);   //unsorted
+
+	auto const report = Analyze::Lint(map);
+	EXPECT_EQ(report.getCount(Analyze::LintCheck::Overlap), 1);
+	EXPECT_EQ(report.getCount(Analyze::LintCheck::ShortHold), 1);
+	EXPECT_EQ(report.getCount(Analyze::LintCheck::ReversedHold), 1);
+	EXPECT_EQ(report.getCount(Analyze::LintCheck::InBreak), 1);
+	EXPECT_EQ(report.getCount(Analyze::LintCheck::Unsorted), 1);
+	ASSERT_EQ(report.issues.size(), 5);
+	EXPECT_EQ(report.issues.front().time, 300);
+	EXPECT_EQ(report.issues.front().column, 1);
+	EXPECT_EQ(report.issues.back().check, Analyze::LintCheck::InBreak);
+	EXPECT_EQ(report.issues.back().index, 5);
+}
+
+TEST(Lint, CleanMap)
+{
+	OsuFile f{ std::ifstream{"TestMania.osu"} };
+	EXPECT_EQ(Analyze::Lint(f).getCount(Analyze::LintCheck::Unsorted), 0);
+	EXPECT_EQ(Analyze::Lint(f).getCount(Analyze::LintCheck::ReversedHold), 0);
+}
@@ -178,12 +178,173 @@ TEST(Helper, SplitOptionalSliderParam)
 #include "RandomEngine.hpp"
 TEST(Random, RandomFloat)
 {
-	auto const rand = RandomEngine::getRand();
+	RandomEngine random;
+	auto const rand = random.getRand();
 	EXPECT_TRUE(0.0 <= rand && rand <= 1.0);
 }
 
 TEST(Random, RandomInt)
 {
-	auto const rand = RandomEngine::getRand(Range{ 1, 7 });
+	RandomEngine random;
+	auto const rand = random.getRand(Range{ 1, 7 });
 	EXPECT_TRUE(1 <= rand && rand <= 7);
 }
+
+TEST(Random, Seed)
+{
+	RandomEngine a{ 42 }, b{ 42 }, c{ 43 };
+	std::vector<int> resultA, resultB, resultC;
+	for (int i = 0; i < 100; ++i)
+	{
+		resultA.push_back(a.getRand(0, 1000));
+		resultB.push_back(b.getRand(0, 1000));
+		resultC.push_back(c.getRand(0, 1000));
+	}
+	EXPECT_EQ(resultA, resultB);
+	EXPECT_NE(resultA, resultC);
+}
+
+TEST(Random, Split)
+{
+	RandomEngine random{ 42 };
+	auto stream = random.split();
+
+	/*The split stream continues where the original was, and the original jumped ahead*/
+	RandomEngine same{ 42 };
+	EXPECT_EQ(stream.getRand(0, 1 << 30), same.getRand(0, 1 << 30));
+	EXPECT_NE(random.getRand(0, 1 << 30), RandomEngine{ 42 }.getRand(0, 1 << 30));
+}
+
+#include "ThreadPool.hpp"
+TEST(ThreadPool, RunsEveryJob)
+{
+	std::atomic<int> sum{};
+	std::vector<std::future<int>> results;
+	{
+		ThreadPool pool{ 4 };
+		EXPECT_EQ(pool.size(), 4);
+		for (int i = 0; i < 1000; ++i)
+			results.push_back(pool.submit([i, &sum] { sum += i; return i * 2; }));
+	}
+	EXPECT_EQ(sum, 999 * 1000 / 2);
+	for (int i = 0; i < 1000; ++i)
+		EXPECT_EQ(results[i].get(), i * 2);
+}
+
+TEST(ThreadPool, Exception)
+{
+	ThreadPool pool{ 2 };
+	auto result = pool.submit([]() -> int { throw std::runtime_error{ "failed" }; });
+	EXPECT_THROW(result.get(), std::runtime_error);
+	EXPECT_EQ(pool.submit([] { return 1; }).get(), 1);
+}
+
+TEST(ThreadPool, Steal)
+{
+	/*The first queue gets a job blocking its worker, the job behind it has to be stolen*/
+	ThreadPool pool{ 2 };
+	std::promise<void> release;
+	auto blocked = pool.submit([future = release.get_future()]() mutable { future.wait(); });
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 20 });
+	(void)pool.submit([] {});
+	auto stolen = pool.submit([] {});
+
+	EXPECT_EQ(stolen.wait_for(std::chrono::seconds{ 5 }), std::future_status::ready);
+	EXPECT_GE(pool.getStealCount(), 1u);
+	release.set_value();
+	blocked.get();
+}
+
+#include "DirectoryWalker.hpp"
+#include <set>
+#include <fstream>
+TEST(DirectoryWalker, FindsEveryFile)
+{
+	namespace fs = std::filesystem;
+	fs::path const root{ "WalkerTree" };
+	fs::remove_all(root);
+	std::set<fs::path> expected;
+	for (int set = 0; set < 20; ++set)
+	{
+		auto const folder = root / ("Set " + std::to_string(set)) / "Nested";
+		fs::create_directories(folder);
+		for (int map = 0; map < set % 4; ++map)
+		{
+			auto const path = (map % 2 ? folder : folder.parent_path()) / (std::to_string(map) + ".osu");
+			std::ofstream{ path };
+			expected.insert(path);
+		}
+	}
+	fs::create_directories(root / "Empty");
+
+	std::mutex mutex;
+	std::set<fs::path> found;
+	DirectoryWalker walker{ 4 };
+	walker.walk(root, [&](fs::directory_entry const& entry)
+	{
+		std::lock_guard lock{ mutex };
+		EXPECT_TRUE(found.insert(entry.path()).second) << entry.path();
+	});
+	EXPECT_EQ(found, expected);
+	EXPECT_EQ(walker.getDirectoryCount(), 1 + 20 * 2 + 1);
+}
+
+TEST(DirectoryWalker, Errors)
+{
+	EXPECT_THROW(DirectoryWalker{}.walk("NoSuchDirectory", [](auto const&) {}), std::filesystem::filesystem_error);
+
+	std::filesystem::create_directories("WalkerError");
+	std::ofstream{ "WalkerError/1.osu" };
+	EXPECT_THROW(DirectoryWalker{ 2 }.walk("WalkerError", [](auto const&) { throw std::runtime_error{ "failed" }; }), std::runtime_error);
+}
+
+#include "Logger.hpp"
+#include <map>
+TEST(Logger, OrderAndLevel)
+{
+	auto& logger = Logger::Get();
+	std::vector<LogRecord> records;
+	logger.setSink([&records](LogRecord const& record) { records.push_back(record); });
+
+	std::vector<std::thread> threads;
+	for (int thread = 0; thread < 4; ++thread)
+	{
+		threads.emplace_back([thread]
+		{
+			for (int i = 0; i < 3000; ++i)
+				Log(LogLevel::Info, thread, ' ', i, '\n');
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	logger.setLevel(LogLevel::Warning);
+	Log(LogLevel::Info, "hidden");
+	Log(LogLevel::Error, "shown");
+	logger.flush();
+	logger.setLevel(LogLevel::Info);
+	logger.setSink(Logger::TextSink());
+
+	ASSERT_EQ(records.size(), 4 * 3000 + 1);
+	EXPECT_EQ(records.back().message, "shown");
+	EXPECT_EQ(records.back().level, LogLevel::Error);
+
+	/*Every thread's messages in the order it logged them, without the line break*/
+	std::map<char, int> next;
+	for (size_t i = 0; i + 1 < records.size(); ++i)
+	{
+		auto const& message = records[i].message;
+		EXPECT_EQ(message.substr(2), std::to_string(next[message[0]]++)) << message;
+	}
+}
+
+TEST(Logger, JsonSink)
+{
+	std::ostringstream os;
+	LogRecord const record{ LogLevel::Warning, std::chrono::system_clock::time_point{ std::chrono::milliseconds{ 1'700'000'000'007 } }, 5, 2, "Map \"A\"\n\tC:\\x\x01" };
+	Logger::JsonSink(os)(record);
+	EXPECT_EQ(os.str(), R"({"time":"2023-11-14T22:13:20.007Z","level":"warning","thread":2,"message":"Map \"A\"\n\tC:\\x\u0001"})" "\n");
+
+	EXPECT_EQ(ParseLogLevel("debug"), LogLevel::Debug);
+	EXPECT_EQ(ParseLogLevel("off"), LogLevel::Off);
+	EXPECT_FALSE(ParseLogLevel("verbose"));
+}
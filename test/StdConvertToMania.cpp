@@ -1,5 +1,18 @@
 #include "BeatmapConvert/include/BeatmapConvert.hpp"
+#include "BeatmapConvert/include/Pipeline.hpp"
+#include "BeatmapConvert/include/Manifest.hpp"
+#include "BeatmapConvert/include/ConversionCache.hpp"
+#include "BeatmapConvert/include/Watch.hpp"
+#include "BeatmapConvert/include/Daemon.hpp"
+#include "BeatmapConvert/include/BulkIO.hpp"
+#include "BeatmapConvert/include/Admission.hpp"
 #include <gtest/gtest.h>
+#include <map>
+#include <sstream>
+#include <fstream>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
 
 TEST(HelperFunction, FlagChange)
 {
@@ -14,6 +27,49 @@ TEST(HelperFunction, FlagChange)
 	EXPECT_FALSE(type & Mania::Pattern::Type::ReverseStair);
 }
 
+TEST(Pattern, Columns)
+{
+	Mania::Pattern pattern{ 4 };
+	pattern += Mania::ManiaNote{ 1, 100, 100 };
+	pattern += Mania::ManiaNote{ 3, 100, 500 };
+
+	Mania::Pattern row{ 4 };
+	row += Mania::ManiaNote{ 1, 200, 200 };
+	pattern += std::move(row);
+
+	EXPECT_TRUE(pattern.colunmHasObject(1));
+	EXPECT_TRUE(pattern.colunmHasObject(3));
+	EXPECT_FALSE(pattern.colunmHasObject(0));
+	EXPECT_EQ(pattern.numColumnWithObject(), 2);
+	EXPECT_EQ(pattern.notes.size(), 3);
+
+	std::vector<std::unique_ptr<HitObject>> result;
+	pattern.materialize(result, Circle{ 0, 0, 100, HitObject::HitSound{}, HitObject::HitSample{} });
+	ASSERT_EQ(result.size(), 3);
+	EXPECT_EQ(result[0]->type, HitObject::Type::Circle);
+	EXPECT_EQ(result[1]->type, HitObject::Type::Hold);
+	EXPECT_EQ(result[1]->getColumnIndex(4), 3);
+	EXPECT_EQ(static_cast<Hold const&>(*result[1]).endTime, 500);
+}
+
+TEST(Pattern, ColumnPolicies)
+{
+	RandomEngine random{ 1 };
+	std::uint32_t const valid = 0b10110;    //columns 1, 2, 4
+
+	EXPECT_EQ(Mania::CyclicColumn{}(valid, 2, random), 4);
+	EXPECT_EQ(Mania::CyclicColumn{}(valid, 4, random), 1);
+	EXPECT_EQ(Mania::CyclicColumn{}(valid, 0, random), 1);
+
+	std::array<int, 5> picked{};
+	for (int i = 0; i < 300; ++i)
+		++picked[Mania::RandomColumn{}(valid, 0, random)];
+	EXPECT_EQ(picked[0] + picked[3], 0);
+	EXPECT_GT(picked[1], 0);
+	EXPECT_GT(picked[2], 0);
+	EXPECT_GT(picked[4], 0);
+}
+
 class ManiaConvertFixture : public ::testing::Test
 {
 protected:
@@ -44,15 +100,784 @@ TEST_F(ManiaConvertFixture, SliderEndTime)
 	//EXPECT_EQ(convertedMap->hitObjects)
 
 	/*DistanceObject*/
-	Mania::DistanceObjectPatternGenerator gen{
-		*originalMap->hitObjects[0],
-		*convertedMap,
-		Mania::Pattern{7},
-		*originalMap,
-		7
+	RandomEngine random;
+	Mania::ConversionContext const context{ *originalMap };
+	ASSERT_EQ(context.objects.size(), originalMap->hitObjects.size());
+
+	Analyze::TimingSweep sweep{ originalMap->timingPoints };
+	for (size_t i = 0; i < originalMap->hitObjects.size(); ++i)
+	{
+		auto const& object = *originalMap->hitObjects[i];
+		if (object.type != HitObject::Type::Slider)
+		{
+			EXPECT_EQ(context.objects[i].endTime, object.time);
+			continue;
+		}
+
+		auto const& slider = static_cast<Slider const&>(object);
+		sweep.advanceTo(object.time);
+		EXPECT_EQ(context.objects[i].endTime, static_cast<int>(std::floor(sweep.getSliderEndTime(slider, originalMap->difficulty.sliderMultiplier))));
+		EXPECT_EQ(context.objects[i].segmentDuration, (context.objects[i].endTime - object.time) / slider.slides);
+
+		Mania::DistanceObjectPatternGenerator<7> gen{
+			object,
+			*convertedMap,
+			Mania::PatternSummary{7},
+			context,
+			static_cast<int>(i),
+			context.objects[i],
+			7,
+			random
+		};
+		EXPECT_EQ(gen.endTime, context.objects[i].endTime);
+		EXPECT_GT(gen.endTime, gen.startTime);
+	}
+}
+
+TEST(ManiaConvert, Reproducible)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	auto const convert = [&f](std::optional<std::uint64_t> seed)
+	{
+		Mania::ManiaBeatmapConverter converter{ f };
+		if (seed)
+			converter.setSeed(*seed);
+
+		std::vector<std::pair<int, int>> notes;
+		for (auto const& note : converter.convertBeatmap().hitObjects)
+			notes.emplace_back(note->time, note->x);
+		return notes;
+	};
+
+	Mania::ManiaBeatmapConverter converter{ f };
+	converter.convertBeatmap();
+	EXPECT_GT(converter.getColumnStats().searches, 0);
+	EXPECT_EQ(converter.getColumnStats().failed, 0);
+
+	EXPECT_EQ(convert({}), convert({}));
+	EXPECT_EQ(convert(1), convert(1));
+	EXPECT_NE(convert(1), convert(2));
+}
+
+TEST(ManiaConvert, ConvertTwice)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	auto const notesOf = [](OsuFile const& map)
+	{
+		std::vector<std::tuple<int, int, HitObject::Type>> notes;
+		for (auto const& note : map.hitObjects)
+			notes.emplace_back(note->time, note->x, note->type);
+		return notes;
+	};
+
+	/*Each conversion starts over from the seed*/
+	Mania::ManiaBeatmapConverter sequential{ f };
+	sequential.setSeed(1);
+	auto const first = notesOf(sequential.convertBeatmap());
+	EXPECT_EQ(notesOf(sequential.convertBeatmap()), first);
+	EXPECT_EQ(notesOf(sequential.convertBeatmaps({ sequential.getKeyCount() }).front()), first);
+
+	Mania::ManiaBeatmapConverter segmented{ f };
+	segmented.setSeed(1).setSegments(Mania::SegmentOptions{ 4, 2 });
+	auto const firstSegmented = notesOf(segmented.convertBeatmap());
+	EXPECT_EQ(notesOf(segmented.convertBeatmap()), firstSegmented);
+
+	Mania::ManiaBeatmapConverter candidates{ f };
+	candidates.setSeed(1).setCandidates(Mania::CandidateOptions{ 4, 2 });
+	auto const firstBest = notesOf(candidates.convertBeatmap());
+	EXPECT_EQ(notesOf(candidates.convertBeatmap()), firstBest);
+}
+
+TEST(ManiaConvert, ConvertHitObjectPastEnd)
+{
+	/*Only to call the protected member*/
+	struct Converter : Mania::ManiaBeatmapConverter
+	{
+		using ManiaBeatmapConverter::ManiaBeatmapConverter;
+		using ManiaBeatmapConverter::convertHitObject;
+	};
+
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	Converter converter{ f };
+	size_t noteCount{};
+	for (auto const& object : f.hitObjects)
+		noteCount += converter.convertHitObject(*object).size();
+	EXPECT_GT(noteCount, 0);
+	EXPECT_THROW(converter.convertHitObject(*f.hitObjects.front()), std::out_of_range);
+
+	/*No original objects are kept when streaming*/
+	std::ifstream file{ "TestMapv11.osu" };
+	Mania::StreamPrescan const prescan{ file };
+	Converter streamed{ prescan };
+	EXPECT_THROW(streamed.convertHitObject(*f.hitObjects.front()), std::out_of_range);
+}
+
+TEST(ManiaConvert, SpecializedKeyCount)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	auto const convert = [&f](int keyCount, bool specialized)
+	{
+		Mania::ManiaBeatmapConverter converter{ f };
+		converter.setSeed(1).setTargetColumn(keyCount, specialized);
+
+		std::vector<std::tuple<int, int, HitObject::Type>> notes;
+		for (auto const& note : converter.convertBeatmap().hitObjects)
+			notes.emplace_back(note->time, note->x, note->type);
+		return notes;
+	};
+
+	for (int keyCount = 1; keyCount <= Mania::MaxKeyCount; ++keyCount)
+		EXPECT_EQ(convert(keyCount, true), convert(keyCount, false)) << keyCount << 'K';
+
+	Mania::ManiaBeatmapConverter converter{ f };
+	EXPECT_THROW(converter.setTargetColumn(Mania::MaxKeyCount + 1), std::invalid_argument);
+}
+
+TEST(ManiaConvert, MultipleKeyCounts)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	auto const notesOf = [](OsuFile const& map)
+	{
+		std::vector<std::tuple<int, int, HitObject::Type>> notes;
+		for (auto const& note : map.hitObjects)
+			notes.emplace_back(note->time, note->x, note->type);
+		return notes;
+	};
+
+	std::vector<int> const keyCounts{ 4, 5, 6, 7 };
+	Mania::ManiaBeatmapConverter converter{ f };
+	auto const converted = converter.setSeed(3).convertBeatmaps(keyCounts);
+	ASSERT_EQ(converted.size(), keyCounts.size());
+
+	for (size_t i = 0; i < keyCounts.size(); ++i)
+	{
+		Mania::ManiaBeatmapConverter alone{ f };
+		alone.setSeed(3).setTargetColumn(keyCounts[i]);
+		EXPECT_FLOAT_EQ(converted[i].difficulty.circleSize, keyCounts[i]);
+		EXPECT_EQ(converted[i].general.mode, Mode::Mania);
+		EXPECT_EQ(notesOf(converted[i]), notesOf(alone.convertBeatmap())) << keyCounts[i] << 'K';
+	}
+
+	EXPECT_THROW(Mania::ManiaBeatmapConverter{ f }.convertBeatmaps({ 4, 0 }), std::invalid_argument);
+}
+
+TEST(ManiaConvert, Segments)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	Mania::ConversionContext const context{ f };
+
+	auto const starts = Mania::FindSegmentStarts(f, context, 4);
+	ASSERT_GT(starts.size(), 1);
+	EXPECT_EQ(starts.front(), 0);
+	EXPECT_TRUE(std::is_sorted(starts.cbegin(), starts.cend()));
+	EXPECT_LE(Mania::FindSegmentStarts(f, context, 16).size(), starts.size());
+
+	auto const convert = [&f](unsigned threads)
+	{
+		Mania::ManiaBeatmapConverter converter{ f };
+		converter.setSeed(1).setSegments(Mania::SegmentOptions{ 4, threads });
+
+		std::vector<std::pair<int, int>> notes;
+		for (auto const& note : converter.convertBeatmap().hitObjects)
+			notes.emplace_back(note->time, note->x);
+		EXPECT_EQ(converter.getColumnStats().failed, 0);
+		return notes;
+	};
+
+	auto const single = convert(1);
+	EXPECT_FALSE(single.empty());
+	for (auto const threads : { 2u, 3u, 8u, 0u })
+		EXPECT_EQ(convert(threads), single) << threads << " threads";
+}
+
+TEST(ManiaConvert, Candidates)
+{
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+	auto const convert = [&f](int count, unsigned threads)
+	{
+		Mania::ManiaBeatmapConverter converter{ f };
+		converter.setSeed(1).setCandidates(Mania::CandidateOptions{ count, threads });
+		auto converted = converter.convertBeatmap();
+
+		auto const best = converter.getBestCandidate();
+		EXPECT_TRUE(best.has_value());
+		EXPECT_DOUBLE_EQ(best->penalty, Mania::GetConversionPenalty(Analyze::AnalyzeMania(converted)));
+		return std::pair{ *best, converted.hitObjects.size() };
+	};
+
+	auto const [single, singleSize] = convert(1, 1);
+	EXPECT_EQ(single.index, 0);
+
+	auto const [best, bestSize] = convert(8, 1);
+	EXPECT_LE(best.penalty, single.penalty);
+	for (auto const threads : { 2u, 4u, 0u })
+	{
+		auto const [other, otherSize] = convert(8, threads);
+		EXPECT_EQ(other.index, best.index) << threads << " threads";
+		EXPECT_EQ(otherSize, bestSize);
+	}
+
+	EXPECT_THROW(Mania::ManiaBeatmapConverter{ f }.setCandidates(Mania::CandidateOptions{ 0 }), std::invalid_argument);
+}
+
+TEST(ManiaConvert, Streaming)
+{
+	auto const streamed = [](int keyCount, std::uint64_t seed)
+	{
+		std::ifstream file{ "TestMapv11.osu" };
+		Mania::StreamPrescan const prescan{ file };
+		std::ostringstream os;
+		auto const result = Mania::StreamConvert(file, prescan, os, Mania::StreamOptions{ keyCount, seed, {} });
+		EXPECT_EQ(result.keyCount, keyCount);
+		return std::pair{ os.str(), result };
+	};
+
+	/*A slider whose curve the parser rejects, before the first object, is skipped by both*/
+	{
+		std::ifstream original{ "TestMapv11.osu" };
+		std::ofstream badSlider{ "StreamingBadSlider.osu" };
+		for (std::string line; std::getline(original, line); )
+		{
+			badSlider << line << '\n';
+			if (line.rfind("[HitObjects]", 0) == 0)
+				badSlider << "100,100,1000,2,0,B|x:y,1,90\n";
+		}
+	}
+	for (auto const name : { "TestMapv11.osu", "StreamingBadSlider.osu" })
+	{
+		OsuFile const map{ std::ifstream{ name } };
+		Mania::StreamPrescan const prescan = [name] { std::ifstream file{ name }; return Mania::StreamPrescan{ file }; }();
+		EXPECT_EQ(prescan.objectCount, map.getCount()) << name;
+		EXPECT_EQ(prescan.getDrainTime(), map.getDrainTime()) << name;
+		EXPECT_EQ(prescan.seed, Mania::ManiaBeatmapConverter::GetDefaultSeed(map)) << name;
+		EXPECT_FLOAT_EQ(prescan.getPercentSliderOrSpinner(), (map.getPercentOf<HitObject::Type::Slider, HitObject::Type::Spinner>())) << name;
+		EXPECT_EQ(Mania::ManiaBeatmapConverter{ prescan }.getKeyCount(), Mania::ManiaBeatmapConverter{ map }.getKeyCount()) << name;
+	}
+
+	OsuFile f{ std::ifstream{"TestMapv11.osu"} };
+
+	for (auto const keyCount : { 4, 7 })
+	{
+		Mania::ManiaBeatmapConverter converter{ f };
+		auto const converted = converter.setSeed(5).setTargetColumn(keyCount).convertBeatmap();
+		converted.save(std::ofstream{ "StreamingReference.osu" });
+		std::stringstream reference;
+		reference << std::ifstream{ "StreamingReference.osu" }.rdbuf();
+
+		auto const [text, result] = streamed(keyCount, 5);
+		EXPECT_EQ(result.objectCount, f.getCount());
+		EXPECT_EQ(result.noteCount, converted.getCount());
+		EXPECT_EQ(text, reference.str()) << keyCount << 'K';
+	}
+}
+
+TEST(ManiaConvert, Pipeline)
+{
+	namespace fs = std::filesystem;
+	auto const copyMaps = [](fs::path const& directory)
+	{
+		fs::remove_all(directory);
+		fs::create_directory(directory);
+		std::vector<fs::directory_entry> entries;
+		for (auto const name : { "TestMapv11.osu", "TestMapv14.osu" })
+		{
+			fs::copy_file(name, directory / name);
+			entries.emplace_back(directory / name);
+		}
+		return entries;
+	};
+	auto const converted = [](fs::path const& directory)
+	{
+		std::map<std::string, std::string> files;
+		for (auto const& entry : fs::directory_iterator{ directory })
+		{
+			if (entry.path().filename().string().find("ConvertedBreak") == std::string::npos)
+				continue;
+			std::stringstream content;
+			content << std::ifstream{ entry.path() }.rdbuf();
+			files.emplace(entry.path().filename().string(), content.str());
+		}
+		return files;
+	};
+
+	Mania::ConvertFiles(copyMaps("PipelineReference"), 3, 2);
+
+	Mania::PipelineOptions options;
+	options.readers = 2;
+	options.parsers = 2;
+	options.converters = 2;
+	options.queueCapacity = 1;
+	options.seed = 3;
+	auto entries = copyMaps("Pipeline");
+	entries.emplace_back("Pipeline/Missing.osu");
+	auto const stats = Mania::ConvertPipeline(std::move(entries), options);
+
+	auto const expected = converted("PipelineReference");
+	EXPECT_EQ(expected.size(), 2);
+	EXPECT_EQ(converted("Pipeline"), expected);
+
+	ASSERT_EQ(stats.stages.size(), 4);
+	EXPECT_EQ(stats.stages[0].items, 3);
+	EXPECT_EQ(stats.stages[0].failed, 1);
+	for (size_t i = 1; i < stats.stages.size(); ++i)
+	{
+		EXPECT_EQ(stats.stages[i].items, 2) << stats.stages[i].name;
+		EXPECT_EQ(stats.stages[i].failed, 0) << stats.stages[i].name;
+	}
+	for (size_t i = 0; i + 1 < stats.stages.size(); ++i)
+		EXPECT_LE(stats.stages[i].peakQueued, 2) << stats.stages[i].name;
+
+	for (auto const backend : { Mania::IoBackend::Blocking, Mania::IoBackend::Auto })
+	{
+		options.bulkIO = backend;
+		entries = copyMaps("PipelineBulk");
+		entries.emplace_back("PipelineBulk/Missing.osu");
+		auto const bulkStats = Mania::ConvertPipeline(std::move(entries), options);
+		EXPECT_EQ(converted("PipelineBulk"), expected) << backend;
+		EXPECT_EQ(bulkStats.stages[0].items, 3) << backend;
+		EXPECT_EQ(bulkStats.stages[0].failed, 1) << backend;
+		EXPECT_EQ(bulkStats.stages[3].items, 2) << backend;
+		EXPECT_EQ(bulkStats.stages[3].failed, 0) << backend;
+	}
+
+	/*A folder where the converted map and its shorter name would be saved*/
+	for (auto const bulkIO : { std::optional<Mania::IoBackend>{}, std::optional{ Mania::IoBackend::Blocking } })
+	{
+		options.bulkIO = bulkIO;
+		fs::remove_all("PipelineUnwritable");
+		fs::create_directory("PipelineUnwritable");
+		fs::copy_file("TestMapv11.osu", "PipelineUnwritable/TestMapv11.osu");
+		for (auto const version : { "CollabConvertedBreak", "test" })
+			fs::create_directories(fs::path{ "PipelineUnwritable" } / ("3L - Three Magic (cRyo[iceeicee]) [" + std::string{ version } + "].osu") / "Blocking");
+		auto const failedStats = Mania::ConvertPipeline({ fs::directory_entry{ "PipelineUnwritable/TestMapv11.osu" } }, options);
+		EXPECT_EQ(failedStats.stages[3].items, 1);
+		EXPECT_EQ(failedStats.stages[3].failed, 1) << bulkIO.has_value();
+	}
+}
+
+TEST(ManiaConvert, BulkIO)
+{
+	namespace fs = std::filesystem;
+	fs::path const directory{ "BulkIO" };
+	fs::remove_all(directory);
+	fs::create_directory(directory);
+
+	/*More files than in flight at once, an empty one and one read in several parts*/
+	std::vector<Mania::BulkWrite> files;
+	for (int i = 0; i < 20; ++i)
+		files.push_back({ directory / (std::to_string(i) + ".osu"), std::string(static_cast<size_t>(i) * 1000, static_cast<char>('a' + i)) });
+	files.push_back({ directory / "Large.osu", std::string(3 << 20, 'x') });
+	files.push_back({ directory / "Missing" / "0.osu", "" });
+
+	for (auto const backend : { Mania::IoBackend::Blocking, Mania::IoBackend::Auto })
+	{
+		Mania::BulkIO io{ backend, 4 };
+		EXPECT_NE(io.getBackend(), Mania::IoBackend::Auto);
+
+		auto const errors = io.write(files);
+		ASSERT_EQ(errors.size(), files.size());
+		for (size_t i = 0; i + 1 < files.size(); ++i)
+			EXPECT_FALSE(errors[i]) << files[i].path << ' ' << errors[i].message();
+		EXPECT_EQ(errors.back(), std::errc::no_such_file_or_directory);
+
+		std::vector<fs::path> paths;
+		for (auto const& file : files)
+			paths.push_back(file.path);
+		std::map<fs::path, Mania::BulkRead> read;
+		io.read(paths, [&read](Mania::BulkRead&& file) { read.emplace(file.path, std::move(file)); });
+
+		ASSERT_EQ(read.size(), files.size()) << io.getBackend();
+		for (size_t i = 0; i + 1 < files.size(); ++i)
+		{
+			EXPECT_FALSE(read[files[i].path].error) << files[i].path;
+			EXPECT_EQ(read[files[i].path].content, files[i].content) << files[i].path;
+		}
+		EXPECT_EQ(read[files.back().path].error, std::errc::no_such_file_or_directory);
+		EXPECT_TRUE(read[files.back().path].content.empty());
+	}
+
+	/*Asking for io_uring gets it, or throws where it is not available*/
+	try
+	{
+		EXPECT_EQ(Mania::BulkIO{ Mania::IoBackend::IoUring }.getBackend(), Mania::IoBackend::IoUring);
+	}
+	catch (std::system_error const&)
+	{
+	}
+}
+
+TEST(ManiaConvert, Incremental)
+{
+	namespace fs = std::filesystem;
+	fs::path const root{ "Incremental" };
+	fs::remove_all(root);
+	fs::create_directories(root / "Set");
+	fs::copy_file("TestMapv11.osu", root / "TestMapv11.osu");
+	fs::copy_file("TestMapv14.osu", root / "Set" / "TestMapv14.osu");
+
+	auto const run = [&root](std::optional<std::uint64_t> seed = 1)
+	{
+		auto const stats = Mania::ConvertIncremental(root, seed, 2);
+		EXPECT_EQ(stats.failed, 0);
+		return std::array{ stats.converted, stats.skipped, stats.removed };
+	};
+	auto const outputOf = [&root](std::string const& source)
+	{
+		return root / Mania::Manifest::Load(root).entries.at(source).output;
+	};
+
+	EXPECT_EQ(run(), (std::array<size_t, 3>{ 2, 0, 0 }));
+	auto const manifest = Mania::Manifest::Load(root);
+	ASSERT_EQ(manifest.entries.size(), 2);
+	EXPECT_EQ(manifest.entries.at("Set/TestMapv14.osu").output.rfind("Set/", 0), 0);
+	EXPECT_TRUE(fs::exists(outputOf("TestMapv11.osu")));
+	EXPECT_EQ(run(), (std::array<size_t, 3>{ 0, 2, 0 }));
+
+	/*Touched but the same content*/
+	fs::last_write_time(root / "TestMapv11.osu", fs::last_write_time(root / "TestMapv11.osu") + std::chrono::hours{ 1 });
+	EXPECT_EQ(run(), (std::array<size_t, 3>{ 0, 2, 0 }));
+
+	std::ofstream{ root / "Set" / "TestMapv14.osu", std::ios::app } << '\n';
+	EXPECT_EQ(run(), (std::array<size_t, 3>{ 1, 1, 0 }));
+
+	fs::remove(outputOf("TestMapv11.osu"));
+	EXPECT_EQ(run(), (std::array<size_t, 3>{ 1, 1, 0 }));
+
+	EXPECT_EQ(run(2), (std::array<size_t, 3>{ 2, 0, 0 }));
+
+	auto const removedOutput = outputOf("TestMapv11.osu");
+	fs::remove(root / "TestMapv11.osu");
+	EXPECT_EQ(run(2), (std::array<size_t, 3>{ 0, 1, 1 }));
+	EXPECT_FALSE(fs::exists(removedOutput));
+	EXPECT_EQ(Mania::Manifest::Load(root).entries.size(), 1);
+}
+
+TEST(ManiaConvert, Cache)
+{
+	namespace fs = std::filesystem;
+	fs::remove_all("CacheLibrary");
+	fs::remove_all("CacheStore");
+	std::vector<fs::directory_entry> entries;
+	for (auto const folder : { "A", "B" })
+	{
+		fs::create_directories(fs::path{ "CacheLibrary" } / folder);
+		fs::copy_file("TestMapv11.osu", fs::path{ "CacheLibrary" } / folder / "TestMapv11.osu");
+		entries.emplace_back(fs::path{ "CacheLibrary" } / folder / "TestMapv11.osu");
+	}
+
+	auto const outputName = "3L - Three Magic (cRyo[iceeicee]) [CollabConvertedBreak].osu";
+	{
+		Mania::ConversionCache cache{ "CacheStore" };
+		Mania::ConvertFiles(entries, 1, 1, &cache);
+		auto const stats = cache.getStats();
+		EXPECT_EQ(stats.hits, 1);
+		EXPECT_EQ(stats.misses, 1);
+		EXPECT_EQ(stats.entries, 1);
+	}
+	auto const read = [](fs::path const& path)
+	{
+		std::stringstream content;
+		content << std::ifstream{ path }.rdbuf();
+		return content.str();
+	};
+	auto const firstSeed = read(fs::path{ "CacheLibrary/A" } / outputName);
+	EXPECT_EQ(firstSeed, read(fs::path{ "CacheLibrary/B" } / outputName));
+
+	/*Kept between runs, and the key depends on the parameters*/
+	{
+		Mania::ConversionCache cache{ "CacheStore" };
+		EXPECT_EQ(cache.getStats().entries, 1);
+		Mania::ConvertFiles({ entries[0] }, 1, 1, &cache);
+		Mania::ConvertFiles({ entries[0] }, 2, 1, &cache);
+		auto const stats = cache.getStats();
+		EXPECT_EQ(stats.hits, 1);
+		EXPECT_EQ(stats.misses, 1);
+		EXPECT_EQ(stats.entries, 2);
+	}
+	EXPECT_NE(read(fs::path{ "CacheLibrary/A" } / outputName), firstSeed);
+
+	/*Saving over a hit leaves the cached map as it was*/
+	{
+		Mania::ConversionCache cache{ "CacheStore" };
+		Mania::ConvertFiles({ entries[1] }, 1, 1, &cache);
+		EXPECT_EQ(cache.getStats().hits, 1);
+	}
+	EXPECT_EQ(read(fs::path{ "CacheLibrary/B" } / outputName), firstSeed);
+}
+
+TEST(ConversionCache, LeastRecentlyUsed)
+{
+	namespace fs = std::filesystem;
+	fs::remove_all("CacheSmall");
+	fs::create_directories("CacheSmall/Out");
+	for (auto const name : { "1.osu", "2.osu", "3.osu" })
+		std::ofstream{ fs::path{ "CacheSmall/Out" } / name } << std::string(100, 'x');
+
+	Mania::ConversionCache cache{ "CacheSmall/Store", 250 };
+	cache.store(1, "CacheSmall/Out/1.osu");
+	cache.store(2, "CacheSmall/Out/2.osu");
+	EXPECT_EQ(cache.fetch(1, "CacheSmall"), fs::path{ "CacheSmall/1.osu" });
+	cache.store(3, "CacheSmall/Out/3.osu");
+
+	auto const stats = cache.getStats();
+	EXPECT_EQ(stats.evictions, 1);
+	EXPECT_EQ(stats.entries, 2);
+	EXPECT_EQ(stats.bytes, 200);
+	EXPECT_TRUE(cache.fetch(2, "CacheSmall").empty());
+	EXPECT_FALSE(cache.fetch(1, "CacheSmall").empty());
+	EXPECT_FALSE(cache.fetch(3, "CacheSmall").empty());
+	EXPECT_NE(Mania::ConversionCache::GetKey("map", "v1"), Mania::ConversionCache::GetKey("map", "v2"));
+}
+
+TEST(ManiaConvert, MemoryBudget)
+{
+	std::ifstream file{ "TestMapv11.osu", std::ios::binary };
+	std::string const content{ std::istreambuf_iterator<char>{ file }, std::istreambuf_iterator<char>{} };
+	auto const estimate = Mania::EstimateConversionMemory(content);
+	EXPECT_GT(estimate, 2 * content.size());
+	EXPECT_GE(Mania::EstimateConversionMemoryBound(content.size()), estimate);
+
+	/*Storyboard lines are only held as text*/
+	auto storyboard = content;
+	std::string sprites;
+	for (int i = 0; i < 1000; ++i)
+		sprites += "Sprite,Foreground,Centre,\"sb/star.png\",320,240\n _F,0," + std::to_string(i) + ",500,1,0\n";
+	storyboard.insert(storyboard.find("[Events]") + 10, sprites);
+	EXPECT_EQ(Mania::EstimateConversionMemory(storyboard), estimate + 2 * sprites.size());
+
+	/*Never more admitted than the budget, except one conversion over it alone*/
+	Mania::MemoryBudget budget{ 100 };
+	std::mutex mutex;
+	std::uint64_t inUse{};
+	int running{};
+	std::vector<std::thread> threads;
+	for (int i = 0; i < 12; ++i)
+	{
+		threads.emplace_back([&, bytes = i % 4 == 0 ? 150u : 40u]
+		{
+			auto const reservation = budget.admit(bytes);
+			{
+				std::lock_guard lock{ mutex };
+				inUse += bytes;
+				++running;
+				EXPECT_TRUE(running == 1 || inUse <= 100) << running << " running in " << inUse << " bytes";
+			}
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 2 });
+			std::lock_guard lock{ mutex };
+			inUse -= bytes;
+			--running;
+		});
+	}
+	for (auto& thread : threads)
+		thread.join();
+	auto const stats = budget.getStats();
+	EXPECT_EQ(stats.admitted, 12);
+	EXPECT_GT(stats.waited, 0);
+	EXPECT_LE(stats.peakAdmitted, 150);
+
+	/*Shrinking a reservation lets the next one in*/
+	{
+		auto reservation = budget.admit(90);
+		auto next = std::async(std::launch::async, [&budget] { return budget.admit(50); });
+		EXPECT_EQ(next.wait_for(std::chrono::milliseconds{ 20 }), std::future_status::timeout);
+		reservation.shrink(40);
+		EXPECT_EQ(next.wait_for(std::chrono::seconds{ 5 }), std::future_status::ready);
+	}
+
+	/*A budget smaller than any map converts them one at a time*/
+	namespace fs = std::filesystem;
+	fs::remove_all("Admission");
+	fs::create_directory("Admission");
+	std::vector<fs::directory_entry> entries;
+	for (auto const name : { "TestMapv11.osu", "TestMapv14.osu" })
+	{
+		fs::copy_file(name, fs::path{ "Admission" } / name);
+		entries.emplace_back(fs::path{ "Admission" } / name);
+	}
+	auto const largest = std::max(fs::file_size(entries[0]), fs::file_size(entries[1]));
+	Mania::MemoryBudget small{ 1 };
+	Mania::ConvertFiles(entries, 1, 2, nullptr, &small);
+	EXPECT_EQ(std::distance(fs::directory_iterator{ "Admission" }, fs::directory_iterator{}), 4);
+	auto const smallStats = small.getStats();
+	EXPECT_EQ(smallStats.admitted, 2);
+	/*Admitted by the size of the file, before it is read*/
+	EXPECT_EQ(smallStats.peakAdmitted, Mania::EstimateConversionMemoryBound(largest));
+#ifdef __linux__
+	EXPECT_GT(smallStats.peakRss, 0);
+#endif
+}
+
+#ifdef __linux__
+TEST(ManiaConvert, Watch)
+{
+	namespace fs = std::filesystem;
+	fs::remove_all("WatchLibrary");
+	fs::create_directories("WatchLibrary");
+	std::ofstream{ "WatchLibrary/Existing.osu" };
+
+	std::mutex mutex;
+	std::condition_variable convertedOne;
+	std::vector<std::pair<fs::path, fs::path>> converted;
+	Mania::WatchOptions options;
+	options.debounce = std::chrono::milliseconds{ 50 };
+	options.seed = 1;
+	options.threads = 1;
+	options.onConverted = [&](fs::path const& source, fs::path const& output)
+	{
+		std::lock_guard lock{ mutex };
+		converted.emplace_back(source, output);
+		convertedOne.notify_one();
 	};
+	Mania::LibraryWatcher watcher{ "WatchLibrary", options };
+	std::thread watching{ [&watcher] { watcher.run(); } };
+
+	/*A new set folder, and a map written in 2 steps*/
+	auto const start = std::chrono::steady_clock::now();
+	fs::create_directories("WatchLibrary/Set");
+	std::stringstream map;
+	map << std::ifstream{ "TestMapv11.osu" }.rdbuf();
+	auto const half = map.str().size() / 2;
+	std::ofstream{ "WatchLibrary/Set/Map.osu" } << map.str().substr(0, half);
+	std::ofstream{ "WatchLibrary/Set/Map.osu", std::ios::app } << map.str().substr(half);
+
+	{
+		std::unique_lock lock{ mutex };
+		ASSERT_TRUE(convertedOne.wait_for(lock, std::chrono::seconds{ 10 }, [&] { return !converted.empty(); }));
+	}
+	auto const latency = std::chrono::steady_clock::now() - start;
+	std::this_thread::sleep_for(std::chrono::milliseconds{ 300 });
+	watcher.stop();
+	watching.join();
+
+	ASSERT_EQ(converted.size(), 1);
+	EXPECT_EQ(converted[0].first, fs::path{ "WatchLibrary/Set/Map.osu" });
+	EXPECT_EQ(converted[0].second.parent_path(), fs::path{ "WatchLibrary/Set" });
+	EXPECT_TRUE(fs::exists(converted[0].second));
+	EXPECT_LT(latency, std::chrono::seconds{ 1 });
+
+	auto const stats = watcher.getStats();
+	EXPECT_EQ(stats.converted, 1);
+	EXPECT_EQ(stats.failed, 0);
+	EXPECT_GE(stats.ignored, 1);
 }
 
+TEST(ManiaConvert, WatchWrittenWhileConverting)
+{
+	namespace fs = std::filesystem;
+	fs::remove_all("WatchBusyLibrary");
+	fs::create_directories("WatchBusyLibrary");
+	std::stringstream map;
+	map << std::ifstream{ "TestMapv11.osu" }.rdbuf();
+
+	/*The first conversion rewrites its source and stays busy past the debounce, while a second thread is free*/
+	std::mutex mutex;
+	std::condition_variable convertedOne;
+	int active = 0;
+	int maxActive = 0;
+	int conversions = 0;
+	Mania::WatchOptions options;
+	options.debounce = std::chrono::milliseconds{ 20 };
+	options.seed = 1;
+	options.threads = 2;
+	options.onConverted = [&](fs::path const& source, fs::path const&)
+	{
+		int count;
+		{
+			std::lock_guard lock{ mutex };
+			maxActive = std::max(maxActive, ++active);
+			count = ++conversions;
+		}
+		if (count == 1)
+		{
+			std::ofstream{ source } << map.str();
+			std::this_thread::sleep_for(std::chrono::milliseconds{ 300 });
+		}
+		std::lock_guard lock{ mutex };
+		--active;
+		convertedOne.notify_one();
+	};
+	Mania::LibraryWatcher watcher{ "WatchBusyLibrary", options };
+	std::thread watching{ [&watcher] { watcher.run(); } };
+
+	std::ofstream{ "WatchBusyLibrary/Map.osu" } << map.str();
+	{
+		std::unique_lock lock{ mutex };
+		EXPECT_TRUE(convertedOne.wait_for(lock, std::chrono::seconds{ 10 }, [&] { return conversions == 2 && active == 0; }));
+	}
+	watcher.stop();
+	watching.join();
+
+	/*Converted again once the first conversion ended, not alongside it*/
+	EXPECT_EQ(conversions, 2);
+	EXPECT_EQ(maxActive, 1);
+	EXPECT_EQ(watcher.getStats().converted, 2);
+}
+#endif
+
+#ifdef __linux__
+TEST(ManiaConvert, Daemon)
+{
+	namespace fs = std::filesystem;
+	fs::remove_all("DaemonLibrary");
+	fs::create_directories("DaemonLibrary");
+	fs::copy_file("TestMapv11.osu", "DaemonLibrary/TestMapv11.osu");
+
+	Mania::Daemon daemon{ "Daemon.sock", Mania::DaemonOptions{ 2, 4 } };
+	std::thread serving{ [&daemon] { daemon.run(); } };
+
+	/*Pipelined on one connection, each answer ends with its own ok or error line*/
+	std::ostringstream answers;
+	auto const failures = Mania::RunDaemonClient("Daemon.sock", {
+		"convert\tDaemonLibrary/TestMapv11.osu\tseed=1",
+		"convert\tDaemonLibrary/TestMapv11.osu\tseed=1\tkeys=7",
+		"analyze\tTestMania.osu",
+		"convert\tDaemonLibrary/Missing.osu",
+		"convert\tDaemonLibrary/TestMapv11.osu\tcolumns=4",
+		"unknown"
+	}, answers);
+	EXPECT_EQ(failures, 3);
+
+	std::map<std::string, std::string> results;
+	std::istringstream lines{ answers.str() };
+	for (std::string line; std::getline(lines, line); )
+	{
+		auto const [id, status, text] = details::SplitString<3>(line, '\t', true);
+		if (status != "-")
+		{
+			EXPECT_TRUE(results.emplace(std::string{ id }, std::string{ status }).second) << line;
+		}
+	}
+	EXPECT_EQ(results, (std::map<std::string, std::string>{ { "1", "ok" }, { "2", "ok" }, { "3", "ok" }, { "4", "error" }, { "5", "error" }, { "6", "error" } }));
+	EXPECT_NE(answers.str().find("1\tok\tDaemonLibrary/3L - Three Magic (cRyo[iceeicee]) [CollabConvertedBreak].osu"), std::string::npos);
+	EXPECT_NE(answers.str().find("[Collab7KConvertedBreak].osu"), std::string::npos);
+	EXPECT_NE(answers.str().find("3\t-\t4K"), std::string::npos);
+
+	/*The same converted map as converting without the daemon*/
+	auto const read = [](fs::path const& path)
+	{
+		std::stringstream content;
+		content << std::ifstream{ path }.rdbuf();
+		return content.str();
+	};
+	OsuFile original{ std::ifstream{ "TestMapv11.osu" } };
+	auto reference = Mania::ConvertForSave(original, 1);
+	reference.save(std::ofstream{ "DaemonReference.osu" });
+	EXPECT_EQ(read("DaemonLibrary/3L - Three Magic (cRyo[iceeicee]) [CollabConvertedBreak].osu"), read("DaemonReference.osu"));
+
+	std::ostringstream stats;
+	EXPECT_EQ(Mania::RunDaemonClient("Daemon.sock", { "stats" }, stats), 0);
+	EXPECT_NE(stats.str().find("1\tok\tconnections=2 requests=7 failed=3"), std::string::npos) << stats.str();
+
+	daemon.stop();
+	serving.join();
+
+	/*The 2 conversions of the same map may both parse it if they run at the same time*/
+	auto const daemonStats = daemon.getStats();
+	EXPECT_EQ(daemonStats.parsedHits + daemonStats.parsedMisses, 3);
+	EXPECT_GE(daemonStats.parsedMisses, 2);
+}
+#endif
+
 #ifdef WIN32
 TEST(ResursiveConvert, RecursiveSaveOnWindows)
 {